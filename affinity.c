@@ -0,0 +1,43 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+
+
+// Read cpu list such as 0,2-3 into cpus, in the order given
+// return number of cpus, -1 when list is malformed
+int parse_cpus(char *list, int *cpus, int max) {
+
+    int count = 0;
+    char *p = list;
+    while (*p != '\0') {
+        char *end;
+        long from = strtol(p, &end, 10);
+        long to = from;
+        if (end == p || from < 0) return -1;
+        if (*end == '-') {
+            p = end + 1;
+            to = strtol(p, &end, 10);
+            if (end == p || to < from) return -1;
+        }
+        for (long cpu = from; cpu <= to; cpu++) {
+            if (count == max || cpu >= MAX_CPUS) return -1;
+            cpus[count++] = cpu;
+        }
+        if (*end != ',' && *end != '\0') return -1;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+
+// Keep calling thread, and what it forks, on the given cpus
+void pin_cpus(int *cpus, int count) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int k = 0; k < count; k++) {
+        CPU_SET(cpus[k], &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+        perror("sched_setaffinity");
+        exit(EXIT_FAILURE);
+    }
+}
\ No newline at end of file
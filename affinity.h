@@ -0,0 +1,15 @@
+#ifndef _AFFINITY_H_
+#define _AFFINITY_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+
+#define MAX_CPUS 1024
+
+int parse_cpus(char *list, int *cpus, int max);
+
+void pin_cpus(int *cpus, int count);
+
+#endif
\ No newline at end of file
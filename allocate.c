@@ -3,14 +3,39 @@
 #include <string.h>
 #include "data.h"
 #include "schedule.h"
+#include "batch.h"
+#include "affinity.h"
+#include "metrics.h"
+#include "loader.h"
 
 int main(int argc, char *argv[]) {
 
     // receive arguments from cmdline
     char *filename = NULL;
-    char *scheduler = NULL;
-    char *mem_strategy = NULL;
-    int quantum = 1;
+    char *manifest = NULL;
+    int threads = 0;
+    int load_threads = 0;
+    options_t opts = {0};
+    int sched_cpus[MAX_CPUS];
+    int child_cpus[MAX_CPUS];
+    int num_sched_cpus = 0;
+    opts.quantum = 1;
+    opts.checkpoint_every = 1000;
+    opts.max_jobs = 65536;
+
+    // paged memory charges the clock for each fault and eviction
+    opts.fault_cost = 1;
+    opts.evict_cost = 1;
+
+    // feedback levels each get twice the quanta of the one above
+    opts.levels = 3;
+    for (int l = 0; l < MAX_LEVELS; l++) {
+        opts.level_quanta[l] = 1 << l;
+    }
+
+    // adaptive round robin slices, in multiples of -q
+    opts.slice_min = 1;
+    opts.slice_max = 8;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-f") == 0) {
@@ -18,22 +43,188 @@ int main(int argc, char *argv[]) {
             filename = argv[i];
         } else if (strcmp(argv[i], "-s") == 0) {
             i++;
-            scheduler = argv[i];
+            opts.scheduler = argv[i];
         } else if (strcmp(argv[i], "-m") == 0) {
             i++;
-            mem_strategy = argv[i];
+            opts.mem_strategy = argv[i];
         } else if (strcmp(argv[i], "-q") == 0) {
             i++;
-            quantum = atoi(argv[i]);
+            opts.quantum = atoll(argv[i]);
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            opts.mem_stats = 1;
+        } else if (strcmp(argv[i], "--mem-sample") == 0) {
+            opts.mem_sample = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            opts.stats = 1;
+        } else if (strcmp(argv[i], "--coalesce") == 0) {
+            opts.coalesce = 1;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            i++;
+            manifest = argv[i];
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            i++;
+            threads = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--load-threads") == 0) {
+            i++;
+            load_threads = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--fast-process") == 0) {
+            opts.fast_process = 1;
+        } else if (strcmp(argv[i], "--pace") == 0) {
+
+            // microseconds of wall clock per unit of simulated time
+            i++;
+            opts.pace = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--cpus") == 0) {
+            i++;
+            num_sched_cpus = parse_cpus(argv[i], sched_cpus, MAX_CPUS);
+            if (num_sched_cpus < 1) {
+                fprintf(stderr, "Bad cpu list %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--child-cpus") == 0) {
+            i++;
+            opts.child_cpus = child_cpus;
+            opts.num_child_cpus = parse_cpus(argv[i], child_cpus, MAX_CPUS);
+            if (opts.num_child_cpus < 1) {
+                fprintf(stderr, "Bad cpu list %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--spread") == 0) {
+            opts.spread = 1;
+        } else if (strcmp(argv[i], "--daemon") == 0) {
+
+            // processes are submitted on a Unix socket instead of a trace
+            i++;
+            opts.daemon = argv[i];
+        } else if (strcmp(argv[i], "--max-jobs") == 0) {
+            i++;
+            opts.max_jobs = atoi(argv[i]);
+            if (opts.max_jobs < 1) opts.max_jobs = 1;
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            i++;
+            opts.metrics = argv[i];
+        } else if (strcmp(argv[i], "--read-metrics") == 0) {
+
+            // print what a running scheduler last exported, then quit
+            i++;
+            if (!read_metrics(argv[i], stdout)) {
+                fprintf(stderr, "Can not read metrics %s\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--shm-transport") == 0) {
+            opts.shm_transport = 1;
+        } else if (strcmp(argv[i], "--verify-hashes") == 0) {
+            opts.verify_hashes = 1;
+        } else if (strcmp(argv[i], "--simulate") == 0) {
+            opts.simulate = 1;
+        } else if (strcmp(argv[i], "--checkpoint") == 0) {
+            i++;
+            opts.checkpoint = argv[i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0) {
+            i++;
+            opts.checkpoint_every = atoll(argv[i]);
+            if (opts.checkpoint_every < 1) opts.checkpoint_every = 1;
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            i++;
+            opts.resume = argv[i];
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            opts.compact = 1;
+        } else if (strcmp(argv[i], "--compact-cost") == 0) {
+            i++;
+            opts.compact_cost = atof(argv[i]);
+        } else if (strcmp(argv[i], "--fault-cost") == 0) {
+            i++;
+            opts.fault_cost = atoll(argv[i]);
+            if (opts.fault_cost < 0) opts.fault_cost = 0;
+        } else if (strcmp(argv[i], "--evict-cost") == 0) {
+            i++;
+            opts.evict_cost = atoll(argv[i]);
+            if (opts.evict_cost < 0) opts.evict_cost = 0;
+        } else if (strcmp(argv[i], "--levels") == 0) {
+            i++;
+            opts.levels = atoi(argv[i]);
+            if (opts.levels < 1) opts.levels = 1;
+            if (opts.levels > MAX_LEVELS) opts.levels = MAX_LEVELS;
+        } else if (strcmp(argv[i], "--level-quanta") == 0) {
+
+            // comma separated quanta per level, in multiples of -q
+            i++;
+            char *token = strtok(argv[i], ",");
+            for (int l = 0; l < MAX_LEVELS && token != NULL; l++) {
+                opts.level_quanta[l] = atoi(token);
+                if (opts.level_quanta[l] < 1) {
+                    fprintf(stderr, "Bad level quanta %s\n", token);
+                    exit(EXIT_FAILURE);
+                }
+                token = strtok(NULL, ",");
+            }
+        } else if (strcmp(argv[i], "--slice-bounds") == 0) {
+
+            // shortest and longest slice, in multiples of -q
+            i++;
+            sscanf(argv[i], "%d,%d", &opts.slice_min, &opts.slice_max);
+            if (opts.slice_min < 1) opts.slice_min = 1;
+            if (opts.slice_max < opts.slice_min) {
+                opts.slice_max = opts.slice_min;
+            }
+        } else if (strcmp(argv[i], "--boost") == 0) {
+            i++;
+            opts.boost = atoll(argv[i]);
         }
     }
 
-    // read process list
+    // scheduler and any batch threads stay on the given cpus
+    if (num_sched_cpus > 0) pin_cpus(sched_cpus, num_sched_cpus);
+
+    // many traces at once, each with its own state and output
+    if (manifest != NULL) {
+        if (opts.checkpoint != NULL || opts.resume != NULL) {
+            fprintf(stderr, "Checkpoints are not kept in batch mode\n");
+            exit(EXIT_FAILURE);
+        }
+        if (opts.metrics != NULL) {
+            fprintf(stderr, "Metrics are not exported in batch mode\n");
+            exit(EXIT_FAILURE);
+        }
+        if (opts.daemon != NULL) {
+            fprintf(stderr, "Daemon mode takes no batch\n");
+            exit(EXIT_FAILURE);
+        }
+        if (run_batch(manifest, threads, load_threads, &opts) > 0) {
+            exit(EXIT_FAILURE);
+        }
+        return 0;
+    }
+
+    // all state of the run lives in one arena
+    arena_t *arena = create_arena(ARENA_CHUNK);
+
+    // every process comes from clients, none from a trace
+    if (opts.daemon != NULL) {
+        process_t **process_list = create_processes(opts.max_jobs, arena);
+        start_scheduling(process_list, 0, &opts, arena, stdout, NULL);
+        free_arena(arena);
+        return 0;
+    }
+
+    // read process list, split across threads when asked
     int process_num;
-    process_t **process_list = read_process(filename, &process_num);
+    process_t **process_list;
+    if (load_threads > 0) {
+        process_list = load_process(filename, &process_num, load_threads, 
+                                    arena);
+    } else {
+        process_list = read_process(filename, &process_num, arena);
+    }
+    if (process_list == NULL) {
+        fprintf(stderr, "Can not read trace %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
 
     // start process schedulin
-    start_scheduling(process_list, scheduler, process_num, quantum, 
-                     mem_strategy);
+    start_scheduling(process_list, process_num, &opts, arena, stdout, NULL);
+
+    free_arena(arena);
 
 }
\ No newline at end of file
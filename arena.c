@@ -0,0 +1,151 @@
+#include "arena.h"
+
+typedef struct chunk chunk_t;
+
+struct chunk
+{
+    chunk_t *next;
+    size_t size;
+    size_t used;
+};
+
+struct arena
+{
+    arena_t *parent;
+    chunk_t *first;
+    chunk_t *current;
+    size_t chunk_size;
+    size_t total;
+};
+
+
+// Round size up to allocation alignment
+static size_t align_size(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+
+// Get first usable byte of chunk
+static uint8_t *chunk_data(chunk_t *chunk) {
+    return (uint8_t *)chunk + align_size(sizeof(chunk_t));
+}
+
+
+// Get a new chunk from parent arena or the system
+static chunk_t *new_chunk(arena_t *arena, size_t size) {
+
+    size_t bytes = align_size(sizeof(chunk_t)) + size;
+    chunk_t *chunk = arena->parent != NULL ? 
+                     arena_alloc(arena->parent, bytes) : malloc(bytes);
+    if (chunk == NULL) exit(EXIT_FAILURE);
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+
+// Create arena whose first chunk holds given size
+// arena header lives in that chunk, so teardown is one free
+arena_t *create_arena(size_t size) {
+
+    size_t header = align_size(sizeof(arena_t));
+    size_t bytes = align_size(sizeof(chunk_t)) + header + size;
+    chunk_t *chunk = malloc(bytes);
+    if (chunk == NULL) exit(EXIT_FAILURE);
+
+    chunk->next = NULL;
+    chunk->size = header + size;
+    chunk->used = header;
+
+    arena_t *arena = (arena_t *)chunk_data(chunk);
+    arena->parent = NULL;
+    arena->first = chunk;
+    arena->current = chunk;
+    arena->chunk_size = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+    arena->total = 0;
+
+    return arena;
+}
+
+
+// Create scratch arena carved from parent, for reset between uses
+arena_t *create_scratch(arena_t *parent, size_t size) {
+
+    arena_t *arena = arena_alloc(parent, sizeof(arena_t));
+    arena->parent = parent;
+    arena->chunk_size = size;
+    arena->total = 0;
+    arena->first = new_chunk(arena, size);
+    arena->current = arena->first;
+
+    return arena;
+}
+
+
+// Allocate aligned memory from arena
+void *arena_alloc(arena_t *arena, size_t size) {
+
+    size = align_size(size);
+    chunk_t *chunk = arena->current;
+
+    // move on to a reused or new chunk when current is full
+    while (chunk->used + size > chunk->size) {
+        if (chunk->next == NULL || chunk->next->size < size) {
+            size_t chunk_size = size > arena->chunk_size ? 
+                                size : arena->chunk_size;
+            chunk_t *fresh = new_chunk(arena, chunk_size);
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+        }
+        chunk = chunk->next;
+        chunk->used = 0;
+        arena->current = chunk;
+    }
+
+    void *ptr = chunk_data(chunk) + chunk->used;
+    chunk->used += size;
+    arena->total += size;
+
+    return ptr;
+}
+
+
+// Allocate zeroed memory from arena
+void *arena_calloc(arena_t *arena, size_t count, size_t size) {
+    void *ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+
+// Drop everything allocated, keeping chunks for reuse
+void reset_arena(arena_t *arena) {
+    arena->current = arena->first;
+    arena->first->used = arena->parent == NULL ? 
+                         align_size(sizeof(arena_t)) : 0;
+    arena->total = 0;
+}
+
+
+// Get bytes handed out since creation or last reset
+size_t get_arena_used(arena_t *arena) {
+    return arena->total;
+}
+
+
+// Free arena and every chunk it took from the system
+void free_arena(arena_t *arena) {
+
+    // scratch chunks belong to parent
+    if (arena->parent != NULL) return;
+
+    chunk_t *chunk = arena->first->next;
+    while (chunk != NULL) {
+        chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena->first);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_CHUNK (1 << 20)
+#define SCRATCH_CHUNK (1 << 16)
+
+typedef struct arena arena_t;
+
+arena_t *create_arena(size_t size);
+
+arena_t *create_scratch(arena_t *parent, size_t size);
+
+void *arena_alloc(arena_t *arena, size_t size);
+
+void *arena_calloc(arena_t *arena, size_t count, size_t size);
+
+void reset_arena(arena_t *arena);
+
+size_t get_arena_used(arena_t *arena);
+
+void free_arena(arena_t *arena);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "batch.h"
+
+typedef struct trace
+{
+    char *path;
+    char *output;
+    size_t length;
+    run_stats_t stats;
+    int failed;
+} trace_t;
+
+typedef struct batch
+{
+    trace_t *traces;
+    int count;
+    options_t *opts;
+    int load_threads;
+
+    // next trace to hand out to a worker
+    pthread_mutex_t lock;
+    int next;
+} batch_t;
+
+
+// Read trace paths from manifest, one per line
+// blank lines and lines starting with # are skipped
+static trace_t *read_manifest(char *manifest, int *count, arena_t *arena) {
+
+    FILE *file = fopen(manifest, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Can not read manifest %s\n", manifest);
+        exit(EXIT_FAILURE);
+    }
+
+    // count traces
+    char line[MAX_MANIFEST_LINE];
+    int total = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] != '\n' && line[0] != '#') total++;
+    }
+    trace_t *traces = arena_calloc(arena, total, sizeof(trace_t));
+    fseek(file, 0, SEEK_SET);
+
+    // keep paths in arena
+    int k = 0;
+    while (fgets(line, sizeof(line), file) != NULL && k < total) {
+        if (line[0] == '\n' || line[0] == '#') continue;
+        line[strcspn(line, "\r\n")] = '\0';
+        traces[k].path = arena_alloc(arena, strlen(line) + 1);
+        strcpy(traces[k].path, line);
+        k++;
+    }
+    fclose(file);
+
+    *count = k;
+    return traces;
+}
+
+
+// Run traces one after another until none is left
+// each trace gets its own arena and buffered output
+static void *run_traces(void *arg) {
+
+    batch_t *batch = arg;
+    while (1) {
+        pthread_mutex_lock(&batch->lock);
+        int k = batch->next++;
+        pthread_mutex_unlock(&batch->lock);
+        if (k >= batch->count) break;
+
+        trace_t *trace = &batch->traces[k];
+        arena_t *arena = create_arena(ARENA_CHUNK);
+        int num;
+        process_t **list;
+        if (batch->load_threads > 0) {
+            list = load_process(trace->path, &num, batch->load_threads, 
+                                arena);
+        } else {
+            list = read_process(trace->path, &num, arena);
+        }
+
+        // a trace that can not be read fails alone
+        FILE *out = open_memstream(&trace->output, &trace->length);
+        if (list == NULL) {
+            fprintf(out, "Can not read trace %s\n", trace->path);
+            trace->failed = 1;
+        } else {
+            start_scheduling(list, num, batch->opts, arena, out, 
+                             &trace->stats);
+        }
+        fclose(out);
+
+        free_arena(arena);
+    }
+    return NULL;
+}
+
+
+// Print totals over every process of every trace read
+static void print_batch_summary(trace_t *traces, int count) {
+
+    int failed = 0;
+    int processes = 0;
+    long long turnaround = 0;
+    double max_overhead = 0.0;
+    double total_overhead = 0.0;
+    long long makespan = 0;
+    for (int k = 0; k < count; k++) {
+        if (traces[k].failed) {
+            failed++;
+            continue;
+        }
+        run_stats_t *stats = &traces[k].stats;
+        processes += stats->processes;
+        turnaround += stats->turnaround;
+        total_overhead += stats->total_overhead;
+        if (stats->max_overhead > max_overhead) {
+            max_overhead = stats->max_overhead;
+        }
+        if (stats->makespan > makespan) makespan = stats->makespan;
+    }
+    if (processes == 0) processes = 1;
+
+    // rounded as for a single trace
+    long long average = turnaround / processes;
+    if (turnaround % processes != 0) average++;
+    printf("Batch traces %d\nTurnaround time %lld\nTime overhead %.2lf %.2lf\n"
+           "Makespan %lld\n", count - failed, average, 
+           round(max_overhead * 100) / 100, 
+           round(total_overhead * 100 / processes) / 100, makespan);
+    if (failed > 0) printf("Failed traces %d\n", failed);
+}
+
+
+// Run every trace of manifest on a pool of threads
+// outputs are printed in manifest order, then the batch totals
+// traces are loaded on load_threads threads each when above 0
+// returns the number of traces that could not be read
+int run_batch(char *manifest, int threads, int load_threads, 
+              options_t *opts) {
+
+    arena_t *arena = create_arena(ARENA_CHUNK);
+    batch_t batch;
+    batch.traces = read_manifest(manifest, &batch.count, arena);
+    batch.opts = opts;
+    batch.load_threads = load_threads;
+    batch.next = 0;
+    pthread_mutex_init(&batch.lock, NULL);
+
+    // one thread per core by default, never more than traces
+    if (threads < 1) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > batch.count) threads = batch.count;
+    if (threads < 1) threads = 1;
+
+    pthread_t *workers = arena_alloc(arena, threads * sizeof(pthread_t));
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&workers[t], NULL, run_traces, &batch);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    pthread_mutex_destroy(&batch.lock);
+
+    // print each trace's output under its path
+    int failed = 0;
+    for (int k = 0; k < batch.count; k++) {
+        failed += batch.traces[k].failed;
+        printf("Trace %s\n", batch.traces[k].path);
+        fwrite(batch.traces[k].output, 1, batch.traces[k].length, stdout);
+        free(batch.traces[k].output);
+    }
+    print_batch_summary(batch.traces, batch.count);
+
+    free_arena(arena);
+    return failed;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "data.h"
+#include "schedule.h"
+#include "arena.h"
+#include "loader.h"
+
+#define MAX_MANIFEST_LINE 4096
+
+int run_batch(char *manifest, int threads, int load_threads, 
+              options_t *opts);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/wait.h>
+#include "affinity.h"
+
+// Handshake latency of ./process, unpinned and then pinned
+// usage: ./bench [rounds] [scheduler cpu] [process cpu]
+
+
+// Get monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+// Order latencies for percentiles
+static int compare_latency(const void *a, const void *b) {
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+
+// Send time to process, with signal when given, and check its ack
+static void handshake(int to_child, int from_child, pid_t pid, int sig, 
+                      int time) {
+    uint32_t time_big_endian = htonl(time);
+    write(to_child, &time_big_endian, sizeof(uint32_t));
+    if (sig != 0) kill(pid, sig);
+    uint8_t response;
+    if (read(from_child, &response, 1) != 1 || response != (time & 0xFF)) {
+        fprintf(stderr, "Bad response from process\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+// Time continue round trips to a running process, pinning both ends
+// when cpus are given, and print them in microseconds
+static void run_bench(char *label, int rounds, int sched_cpu, 
+                      int child_cpu, long long *latency) {
+
+    int to_child[2];
+    int from_child[2];
+    pipe(to_child);
+    pipe(from_child);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (child_cpu >= 0) pin_cpus(&child_cpu, 1);
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[1]);
+        close(from_child[0]);
+        char *pargv[] = {"./process", "bench", NULL};
+        execvp(pargv[0], pargv);
+        exit(EXIT_FAILURE);
+    }
+    close(to_child[0]);
+    close(from_child[1]);
+
+    // start, then continue the running process every round
+    handshake(to_child[1], from_child[0], pid, 0, 0);
+    for (int r = 0; r < rounds; r++) {
+        long long start = now_ns();
+        handshake(to_child[1], from_child[0], pid, SIGCONT, r + 1);
+        latency[r] = now_ns() - start;
+    }
+
+    // terminate and collect hash
+    uint32_t time_big_endian = htonl(rounds + 1);
+    write(to_child[1], &time_big_endian, sizeof(uint32_t));
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    char sha[65];
+    read(from_child[0], sha, 64);
+    close(to_child[1]);
+    close(from_child[0]);
+
+    qsort(latency, rounds, sizeof(long long), compare_latency);
+    long long total = 0;
+    for (int r = 0; r < rounds; r++) {
+        total += latency[r];
+    }
+    printf("%s cpus %d %d mean %.2lf p50 %.2lf p99 %.2lf max %.2lf\n", 
+           label, sched_cpu, child_cpu, (double)total / rounds / 1000, 
+           latency[rounds / 2] / 1000.0, 
+           latency[(int)(rounds * 0.99)] / 1000.0, 
+           latency[rounds - 1] / 1000.0);
+}
+
+
+int main(int argc, char *argv[]) {
+
+    int rounds = argc > 1 ? atoi(argv[1]) : 10000;
+    int sched_cpu = argc > 2 ? atoi(argv[2]) : 0;
+    int child_cpu = argc > 3 ? atoi(argv[3]) : sched_cpu;
+    if (rounds < 1) rounds = 1;
+    long long *latency = malloc(rounds * sizeof(long long));
+
+    // unpinned first, while affinity is still the inherited one
+    run_bench("unpinned", rounds, -1, -1, latency);
+
+    pin_cpus(&sched_cpu, 1);
+    run_bench("pinned", rounds, sched_cpu, child_cpu, latency);
+
+    free(latency);
+    return 0;
+}
\ No newline at end of file
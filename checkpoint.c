@@ -0,0 +1,212 @@
+#include "checkpoint.h"
+
+
+// Hash process list so a checkpoint is only resumed on its own trace
+static uint32_t trace_hash(run_t *run) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < run->n; i++) {
+        long long fields[5] = {get_arrival_time(run->p[i]), 
+                               get_service_time(run->p[i]), 
+                               get_process_mem(run->p[i]), 
+                               get_process_priority(run->p[i]), i};
+        uint8_t *bytes = (uint8_t *)fields;
+        for (size_t k = 0; k < sizeof(fields); k++) {
+            hash = (hash ^ bytes[k]) * 16777619u;
+        }
+        char *name = get_process_name(run->p[i]);
+        for (size_t k = 0; name[k] != '\0'; k++) {
+            hash = (hash ^ (uint8_t)name[k]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+
+// Write what a checkpoint must match to be resumed
+static void write_header(run_t *run, FILE *file) {
+    options_t *opts = run->opts;
+    int header[7] = {CHECKPOINT_MAGIC, CHECKPOINT_VERSION, run->n, 
+                     opts->levels, opts->slice_min, opts->slice_max, 
+                     (int)trace_hash(run)};
+    fwrite(header, sizeof(int), 7, file);
+    fwrite(&opts->quantum, sizeof(long long), 1, file);
+
+    int len = strlen(opts->scheduler);
+    fwrite(&len, sizeof(int), 1, file);
+    fwrite(opts->scheduler, 1, len, file);
+    len = strlen(opts->mem_strategy);
+    fwrite(&len, sizeof(int), 1, file);
+    fwrite(opts->mem_strategy, 1, len, file);
+}
+
+
+// Check header against this run, 0 when it was saved by another
+static int check_header(run_t *run, FILE *file) {
+    options_t *opts = run->opts;
+    int header[7] = {0};
+    int expect[7] = {CHECKPOINT_MAGIC, CHECKPOINT_VERSION, run->n, 
+                     opts->levels, opts->slice_min, opts->slice_max, 
+                     (int)trace_hash(run)};
+    long long quantum = 0;
+    if (fread(header, sizeof(int), 7, file) != 7 || 
+        memcmp(header, expect, sizeof(header)) != 0 || 
+        fread(&quantum, sizeof(long long), 1, file) != 1 || 
+        quantum != opts->quantum) {
+        return 0;
+    }
+
+    // scheduler then memory strategy
+    char *names[2] = {opts->scheduler, opts->mem_strategy};
+    for (int k = 0; k < 2; k++) {
+        char name[MAX_PATH];
+        int len = 0;
+        if (fread(&len, sizeof(int), 1, file) != 1 || 
+            len != strlen(names[k]) || 
+            fread(name, 1, len, file) != len || 
+            memcmp(name, names[k], len) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+// Stop on a checkpoint which can not be resumed
+static void bad_checkpoint(char *path, char *reason) {
+    fprintf(stderr, "Checkpoint %s %s\n", path, reason);
+    exit(EXIT_FAILURE);
+}
+
+
+// Write scheduler, allocator and process state to path
+// written beside it first so a crash never leaves half a checkpoint
+void save_checkpoint(run_t *run, char *path) {
+
+    char temp[MAX_PATH];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *file = fopen(temp, "wb");
+    if (file == NULL) bad_checkpoint(path, "can not be written");
+
+    int n = run->n;
+    write_header(run, file);
+
+    // clock, cursors and per process progress
+    long long times[3] = {*run->time, run->admitted_until, run->next_boost};
+    int cursors[8] = {run->fed, run->idle, run->current, run->cursor, 
+                      run->seq, run->finished, run->last, run->backfilled};
+    fwrite(times, sizeof(long long), 3, file);
+    fwrite(cursors, sizeof(int), 8, file);
+    fwrite(run->remain_time, sizeof(long long), n, file);
+    fwrite(run->is_finished, sizeof(int), n, file);
+    fwrite(run->mem_allocated, sizeof(int), n, file);
+    fwrite(run->memstart, sizeof(int), n, file);
+    save_stats(run->stats, file);
+
+    // memory and the processes waiting on it
+    if (run->memory != NULL) save_mem(run->memory, file);
+    if (run->pages != NULL) save_page_table(run->pages, file);
+    save_wait_queue(run->queue, file);
+
+    // policy's ready structures
+    if (run->heap != NULL) save_ready_heap(run->heap, file);
+    if (run->fifo != NULL) save_ready_fifo(run->fifo, file);
+    if (run->levels != NULL) {
+        fwrite(run->level, sizeof(int), n, file);
+        fwrite(run->used, sizeof(int), n, file);
+        for (int l = 0; l < run->opts->levels; l++) {
+            save_ready_fifo(run->levels[l], file);
+        }
+    }
+    if (run->service_quanta != NULL) {
+        int slice[4] = {run->slice, run->slice_used, run->slice_ready, 
+                         run->service_count};
+        fwrite(slice, sizeof(int), 4, file);
+        fwrite(run->service_quanta, sizeof(int), run->opts->slice_max + 1, 
+               file);
+    }
+
+    // simulated processes
+    for (int i = 0; i < n; i++) {
+        save_child(run->child[i], file);
+    }
+
+    int magic = CHECKPOINT_MAGIC;
+    fwrite(&magic, sizeof(int), 1, file);
+    if (ferror(file) || fclose(file) != 0 || rename(temp, path) != 0) {
+        bad_checkpoint(path, "can not be written");
+    }
+}
+
+
+// Restore state written by save_checkpoint into a freshly set up run
+void load_checkpoint(run_t *run, char *path) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) bad_checkpoint(path, "can not be read");
+
+    int n = run->n;
+    if (!check_header(run, file)) {
+        bad_checkpoint(path, "was saved for another trace or options");
+    }
+
+    // clock, cursors and per process progress
+    long long times[3] = {0};
+    int cursors[8] = {0};
+    fread(times, sizeof(long long), 3, file);
+    fread(cursors, sizeof(int), 8, file);
+    *run->time = times[0];
+    run->admitted_until = times[1];
+    run->next_boost = times[2];
+    run->fed = cursors[0];
+    run->idle = cursors[1];
+    run->current = cursors[2];
+    run->cursor = cursors[3];
+    run->seq = cursors[4];
+    run->finished = cursors[5];
+    run->last = cursors[6];
+    run->backfilled = cursors[7];
+    fread(run->remain_time, sizeof(long long), n, file);
+    fread(run->is_finished, sizeof(int), n, file);
+    fread(run->mem_allocated, sizeof(int), n, file);
+    fread(run->memstart, sizeof(int), n, file);
+    load_stats(run->stats, file);
+
+    // memory and the processes waiting on it
+    int loaded = 1;
+    if (run->memory != NULL) loaded &= load_mem(run->memory, file);
+    if (run->pages != NULL) loaded &= load_page_table(run->pages, file);
+    loaded &= load_wait_queue(run->queue, file);
+
+    // policy's ready structures
+    if (run->heap != NULL) loaded &= load_ready_heap(run->heap, file);
+    if (run->fifo != NULL) loaded &= load_ready_fifo(run->fifo, file);
+    if (run->levels != NULL) {
+        fread(run->level, sizeof(int), n, file);
+        fread(run->used, sizeof(int), n, file);
+        for (int l = 0; l < run->opts->levels; l++) {
+            loaded &= load_ready_fifo(run->levels[l], file);
+        }
+    }
+    if (run->service_quanta != NULL) {
+        int slice[4] = {0};
+        fread(slice, sizeof(int), 4, file);
+        run->slice = slice[0];
+        run->slice_used = slice[1];
+        run->slice_ready = slice[2];
+        run->service_count = slice[3];
+        fread(run->service_quanta, sizeof(int), run->opts->slice_max + 1, 
+              file);
+    }
+
+    // simulated processes
+    for (int i = 0; i < n; i++) {
+        load_child(run->child[i], file);
+    }
+
+    int magic = 0;
+    if (!loaded || fread(&magic, sizeof(int), 1, file) != 1 || 
+        magic != CHECKPOINT_MAGIC) {
+        bad_checkpoint(path, "is damaged");
+    }
+    fclose(file);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "schedule.h"
+
+#define CHECKPOINT_MAGIC 0x504b4341
+#define CHECKPOINT_VERSION 8
+#define MAX_PATH 4096
+
+void save_checkpoint(run_t *run, char *path);
+
+void load_checkpoint(run_t *run, char *path);
+
+#endif
\ No newline at end of file
@@ -2,20 +2,45 @@
 
 struct process
 {
-    int arrival;
+    long long arrival;
     char name[MAX_PROCESS_NAME];
-    int service;
+    long long service;
     int memory;
+    int priority;
 };
 
 
+// Allocate empty processes side by side in arena
+process_t **create_processes(int num, arena_t *arena) {
+    process_t **processes = arena_alloc(arena, num * sizeof(process_t *));
+    process_t *storage = arena_alloc(arena, num * sizeof(process_t));
+    for (int i = 0; i < num; i++) {
+        processes[i] = &storage[i];
+    }
+    return processes;
+}
+
+
+// Fill in process given while the run goes on
+void set_process(process_t *process, long long arrival, char *name, 
+                 long long service, int memory, int priority) {
+    process->arrival = arrival;
+    strncpy(process->name, name, MAX_PROCESS_NAME - 1);
+    process->name[MAX_PROCESS_NAME - 1] = '\0';
+    process->service = service;
+    process->memory = memory;
+    process->priority = priority;
+}
+
+
 // Read all process info from file
-process_t **read_process(char *filename, int *num) {
+// returns NULL when the file can not be opened
+process_t **read_process(char *filename, int *num, arena_t *arena) {
 
     // open process list file
     FILE *file = fopen(filename, "r");
     if (file == NULL) {
-        exit(1);
+        return NULL;
     }
 
     // count process lines
@@ -26,19 +51,21 @@ process_t **read_process(char *filename, int *num) {
     }
     *num = line_total;
 
-    // prepare storing process info
-    process_t **processes = malloc(line_total * 
-                                   sizeof(process_t *));
+    // prepare storing process info side by side in run arena
+    process_t **processes = create_processes(line_total, arena);
     fseek(file, 0, SEEK_SET);
 
     // store process into struct
     int i = 0;
     while (fgets(line, sizeof(line), file) != NULL) {
-        processes[i] = malloc(sizeof(process_t));
-        sscanf(line, "%d %s %d %d", &processes[i]->arrival,
-                                    processes[i]->name,
-                                    &processes[i]->service,
-                                    &processes[i]->memory);
+
+        // priority is an optional last column, highest at 0
+        processes[i]->priority = 0;
+        sscanf(line, "%lld %s %lld %d %d", &processes[i]->arrival,
+                                           processes[i]->name,
+                                           &processes[i]->service,
+                                           &processes[i]->memory,
+                                           &processes[i]->priority);
         i++;
     }
 
@@ -52,7 +79,7 @@ process_t **read_process(char *filename, int *num) {
 
 
 // Get process's arrival time
-int get_arrival_time(process_t *process) {
+long long get_arrival_time(process_t *process) {
     return process->arrival;
 }
 
@@ -64,7 +91,7 @@ char *get_process_name(process_t *process) {
 
 
 // Get process's servicing time
-int get_service_time(process_t *process) {
+long long get_service_time(process_t *process) {
     return process->service;
 }
 
@@ -72,4 +99,10 @@ int get_service_time(process_t *process) {
 // Get process's memory requirement
 int get_process_mem(process_t *process) {
     return process->memory;
+}
+
+
+// Get process's static priority
+int get_process_priority(process_t *process) {
+    return process->priority;
 }
\ No newline at end of file
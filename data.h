@@ -5,19 +5,28 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_CHAR_LINE 32
+#include "arena.h"
+
+#define MAX_CHAR_LINE 64
 #define MAX_PROCESS_NAME 8
 
 typedef struct process process_t;
 
-process_t **read_process(char *filename, int *num);
+process_t **create_processes(int num, arena_t *arena);
+
+process_t **read_process(char *filename, int *num, arena_t *arena);
 
-int get_arrival_time(process_t *process);
+void set_process(process_t *process, long long arrival, char *name, 
+                 long long service, int memory, int priority);
+
+long long get_arrival_time(process_t *process);
 
 char *get_process_name(process_t *process);
 
-int get_service_time(process_t *process);
+long long get_service_time(process_t *process);
 
 int get_process_mem(process_t *process);
 
+int get_process_priority(process_t *process);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include <limits.h>
+
+#include "schedule.h"
+
+// Stand-ins for hooks a policy leaves out
+static inline void no_hook(run_t *run) {}
+
+static inline int never_contended(run_t *run, int i) {
+    return 0;
+}
+
+static inline long long no_event(run_t *run) {
+    return LLONG_MAX;
+}
+
+static inline void no_quantum_end(run_t *run, int i, int quanta) {}
+
+static inline void no_finish(run_t *run, int i) {}
+
+// Define run engine loop name for one policy, as run_engine runs it
+// with the hooks called directly and children run through dispatch
+// for runs without checkpoints, daemon, metrics, pacing, compaction
+// or paging, so no option is looked at between quanta
+#define DEFINE_ENGINE(name, dispatch, init, admit, pick_next, contended, \
+                      next_event, on_quantum_end, on_finish) \
+static void name(run_t *run) { \
+    long long q = run->opts->quantum; \
+    long long *remain_time = run->remain_time; \
+    init(run); \
+    while (run->finished < run->n) { \
+        admit(run); \
+        int i = pick_next(run); \
+        if (i == -1) { \
+            skip_to_arrival(run); \
+            continue; \
+        } \
+        int span = get_quanta_left(run, i); \
+        if (span > 1 && contended(run, i)) span = 1; \
+        if (span > 1) span = cap_span(run, span, next_event(run)); \
+        dispatch(run, i, span); \
+        *run->time = *run->time + (long long)span * q; \
+        remain_time[i] -= (long long)span * q; \
+        if (remain_time[i] <= 0) { \
+            on_finish(run, i); \
+            finish_process(run, i); \
+            run->finished++; \
+        } else { \
+            on_quantum_end(run, i, span); \
+        } \
+    } \
+}
+
+// Define real and simulated loops of a policy as policy_real and
+// policy_simulated
+#define DEFINE_ENGINES(policy, init, admit, pick_next, contended, \
+                       next_event, on_quantum_end, on_finish) \
+DEFINE_ENGINE(policy##_real, dispatch_process, init, admit, pick_next, \
+              contended, next_event, on_quantum_end, on_finish) \
+DEFINE_ENGINE(policy##_simulated, dispatch_simulated, init, admit, \
+              pick_next, contended, next_event, on_quantum_end, on_finish)
+
+#endif
\ No newline at end of file
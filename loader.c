@@ -0,0 +1,238 @@
+#include "loader.h"
+
+// Lines of one piece of the trace, parsed into columns
+typedef struct chunk
+{
+    char *start;
+    char *end;
+
+    // columns, grown as lines are parsed
+    int count;
+    int size;
+    long long *arrival;
+    long long *service;
+    int *memory;
+    int *priority;
+    char (*name)[MAX_PROCESS_NAME];
+
+    // lines read, blank ones included, the line of the first process
+    // and the first arriving before the one above it, -1 when none does
+    int lines;
+    int first_line;
+    int bad_line;
+
+    // where the chunk's processes go in the final table
+    process_t **out;
+} chunk_t;
+
+
+// Skip spaces and tabs, but not the end of line
+static char *skip_blank(char *s, char *end) {
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+    return s;
+}
+
+
+// Parse decimal integer at s into value
+// return position after it, or NULL when there is none
+static char *parse_int(char *s, char *end, long long *value) {
+    s = skip_blank(s, end);
+    int sign = 1;
+    if (s < end && (*s == '-' || *s == '+')) {
+        if (*s == '-') sign = -1;
+        s++;
+    }
+    if (s == end || *s < '0' || *s > '9') return NULL;
+    long long v = 0;
+    while (s < end && *s >= '0' && *s <= '9') v = v * 10 + (*s++ - '0');
+    *value = sign * v;
+    return s;
+}
+
+
+// Add room for twice as many processes to chunk's columns
+static void grow_chunk(chunk_t *chunk) {
+    chunk->size = chunk->size > 0 ? chunk->size * 2 : 1024;
+    chunk->arrival = realloc(chunk->arrival, 
+                             chunk->size * sizeof(long long));
+    chunk->service = realloc(chunk->service, 
+                             chunk->size * sizeof(long long));
+    chunk->memory = realloc(chunk->memory, chunk->size * sizeof(int));
+    chunk->priority = realloc(chunk->priority, chunk->size * sizeof(int));
+    chunk->name = realloc(chunk->name, chunk->size * MAX_PROCESS_NAME);
+}
+
+
+// Parse "arrival name service memory [priority]" lines of a chunk
+// fields missing from a line read as 0, as read_process leaves them
+static void *parse_chunk(void *arg) {
+
+    chunk_t *chunk = arg;
+    char *s = chunk->start;
+    while (s < chunk->end) {
+        char *eol = memchr(s, '\n', chunk->end - s);
+        if (eol == NULL) eol = chunk->end;
+        chunk->lines++;
+
+        // blank lines hold no process
+        char *p = skip_blank(s, eol);
+        if (p == eol) {
+            s = eol + 1;
+            continue;
+        }
+        if (chunk->count == chunk->size) grow_chunk(chunk);
+        int k = chunk->count++;
+        long long fields[4] = {0};
+
+        // arrival, then name up to the next blank
+        p = parse_int(p, eol, &fields[0]);
+        if (p != NULL) {
+            p = skip_blank(p, eol);
+            int len = 0;
+            while (p < eol && *p != ' ' && *p != '\t' && *p != '\r') {
+                if (len < MAX_PROCESS_NAME - 1) chunk->name[k][len++] = *p;
+                p++;
+            }
+            chunk->name[k][len] = '\0';
+            for (int f = 1; f < 4 && p != NULL; f++) {
+                p = parse_int(p, eol, &fields[f]);
+            }
+        } else {
+            chunk->name[k][0] = '\0';
+        }
+        chunk->arrival[k] = fields[0];
+        chunk->service[k] = fields[1];
+        chunk->memory[k] = fields[2];
+        chunk->priority[k] = fields[3];
+
+        // schedulers take processes in arrival order
+        if (k == 0) chunk->first_line = chunk->lines;
+        if (k > 0 && chunk->bad_line == -1 && 
+            chunk->arrival[k] < chunk->arrival[k - 1]) {
+            chunk->bad_line = chunk->lines;
+        }
+        s = eol + 1;
+    }
+    return NULL;
+}
+
+
+// Copy chunk's columns into its range of the process table
+static void *fill_chunk(void *arg) {
+    chunk_t *chunk = arg;
+    for (int k = 0; k < chunk->count; k++) {
+        set_process(chunk->out[k], chunk->arrival[k], chunk->name[k], 
+                    chunk->service[k], chunk->memory[k], chunk->priority[k]);
+    }
+    return NULL;
+}
+
+
+// Run fn over every chunk, a thread each
+static void run_chunks(chunk_t *chunks, int count, void *(*fn)(void *)) {
+    pthread_t workers[MAX_LOAD_THREADS];
+    for (int t = 1; t < count; t++) {
+        pthread_create(&workers[t], NULL, fn, &chunks[t]);
+    }
+    fn(&chunks[0]);
+    for (int t = 1; t < count; t++) {
+        pthread_join(workers[t], NULL);
+    }
+}
+
+
+// Stop on a process arriving before the one above it
+static void bad_order(char *filename, int line) {
+    fprintf(stderr, "Trace %s arrival goes back at line %d\n", 
+            filename, line);
+}
+
+
+// Read all process info from file as read_process does, parsing
+// pieces split at line ends on threads and keeping file order
+// arrivals must not go back, which is checked on the way
+// returns NULL when the file can not be read or is out of order
+process_t **load_process(char *filename, int *num, int threads, 
+                         arena_t *arena) {
+
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        if (fd != -1) close(fd);
+        return NULL;
+    }
+    size_t length = st.st_size;
+    char *data = NULL;
+    if (length > 0) {
+        data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return NULL;
+        }
+        madvise(data, length, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // each chunk starts past the line end at or before its share
+    if (threads < 1) threads = 1;
+    if (threads > MAX_LOAD_THREADS) threads = MAX_LOAD_THREADS;
+    if (length < (size_t)threads) threads = 1;
+    chunk_t chunks[MAX_LOAD_THREADS];
+    memset(chunks, 0, threads * sizeof(chunk_t));
+    char *end = data + length;
+    for (int t = 0; t < threads; t++) {
+        char *start = t == 0 ? data : data + length / threads * t;
+        if (t > 0) {
+            char *eol = memchr(start - 1, '\n', end - start + 1);
+            start = eol == NULL ? end : eol + 1;
+        }
+        chunks[t].start = start;
+        chunks[t].bad_line = -1;
+        if (t > 0) chunks[t - 1].end = start;
+    }
+    chunks[threads - 1].end = end;
+    run_chunks(chunks, threads, parse_chunk);
+
+    // place chunks one after another, checking order across edges
+    int total = 0;
+    int lines = 0;
+    int bad = -1;
+    long long last = 0;
+    for (int t = 0; t < threads && bad == -1; t++) {
+        chunk_t *chunk = &chunks[t];
+        if (chunk->count > 0 && total > 0 && chunk->arrival[0] < last) {
+            bad = lines + chunk->first_line;
+        } else if (chunk->bad_line != -1) {
+            bad = lines + chunk->bad_line;
+        }
+        if (chunk->count > 0) last = chunk->arrival[chunk->count - 1];
+        total += chunk->count;
+        lines += chunk->lines;
+    }
+
+    process_t **processes = NULL;
+    if (bad == -1) {
+        processes = create_processes(total, arena);
+        int offset = 0;
+        for (int t = 0; t < threads; t++) {
+            chunks[t].out = processes + offset;
+            offset += chunks[t].count;
+        }
+        run_chunks(chunks, threads, fill_chunk);
+    } else {
+        bad_order(filename, bad);
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(chunks[t].arrival);
+        free(chunks[t].service);
+        free(chunks[t].memory);
+        free(chunks[t].priority);
+        free(chunks[t].name);
+    }
+    if (data != NULL) munmap(data, length);
+
+    *num = total;
+    return processes;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "data.h"
+#include "arena.h"
+
+#define MAX_LOAD_THREADS 256
+
+process_t **load_process(char *filename, int *num, int threads, 
+                         arena_t *arena);
+
+#endif
\ No newline at end of file
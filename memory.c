@@ -1,76 +1,440 @@
 #include "memory.h"
 
+#define HOLE_WORDS (MAX_MEMORY / 64)
+#define SIZE_WORDS (MAX_MEMORY / 64 + 1)
+
 struct memory
 {
     int index;
     int is_allocated;
+    int run;
+};
+
+struct mem_table
+{
+    memory_t **blocks;
+
+    // usage and hole statistics, kept up to date on every change
+    int live;
+    int peak;
+    int holes;
+    int max_holes;
+    int largest_hole;
+    int hole_sizes[MAX_MEMORY + 1];
+
+    // indexed view of holes, bit per hole start and per size in use
+    uint64_t start_bits[HOLE_WORDS];
+    uint64_t size_bits[SIZE_WORDS];
+    int failed;
+    int relocated;
+    double max_fragmentation;
+
+    // time weighted usage for utilisation over the run
+    long long last_time;
+    long long live_area;
+    double fragmentation_area;
 };
 
 
+// Record a free hole, tagging both of its ends with its length
+static void add_hole(mem_table_t *memory, int start, int size) {
+    memory->blocks[start]->run = size;
+    memory->blocks[start + size - 1]->run = size;
+    memory->start_bits[start / 64] |= (uint64_t)1 << (start % 64);
+    if (memory->hole_sizes[size]++ == 0) {
+        memory->size_bits[size / 64] |= (uint64_t)1 << (size % 64);
+    }
+    memory->holes++;
+    if (memory->holes > memory->max_holes) {
+        memory->max_holes = memory->holes;
+    }
+    if (size > memory->largest_hole) {
+        memory->largest_hole = size;
+    }
+}
+
+
+// Forget a free hole which is about to be split or merged
+static void remove_hole(mem_table_t *memory, int start, int size) {
+    memory->start_bits[start / 64] &= ~((uint64_t)1 << (start % 64));
+    if (--memory->hole_sizes[size] == 0) {
+        memory->size_bits[size / 64] &= ~((uint64_t)1 << (size % 64));
+    }
+    memory->holes--;
+
+    // walk down to the next largest hole only when the last one goes
+    while (memory->largest_hole > 0 &&
+           memory->hole_sizes[memory->largest_hole] == 0) {
+        memory->largest_hole--;
+    }
+}
+
+
+// Keep highest usage and fragmentation seen so far
+static void track_peaks(mem_table_t *memory) {
+    if (memory->live > memory->peak) {
+        memory->peak = memory->live;
+    }
+    if (get_mem_fragmentation(memory) > memory->max_fragmentation) {
+        memory->max_fragmentation = get_mem_fragmentation(memory);
+    }
+}
+
+
+// Allocate the front of the hole starting at start
+static void take_hole(mem_table_t *memory, int start, int size) {
+
+    int hole_size = memory->blocks[start]->run;
+    for (int i = start; i < start + size; i++) {
+        memory->blocks[i]->is_allocated = 1;
+    }
+
+    // split hole, keeping what is left behind the allocation
+    remove_hole(memory, start, hole_size);
+    if (hole_size > size) {
+        add_hole(memory, start + size, hole_size - size);
+    }
+
+    memory->live += size;
+    track_peaks(memory);
+}
+
+
 // Create memory blocks table
-memory_t **create_mem_table() {
-    memory_t **memory = malloc(MAX_MEMORY * sizeof(memory_t **));
+mem_table_t *create_mem_table(arena_t *arena) {
+    mem_table_t *memory = arena_calloc(arena, 1, sizeof(mem_table_t));
+    memory->blocks = arena_alloc(arena, MAX_MEMORY * sizeof(memory_t *));
+    memory_t *storage = arena_alloc(arena, MAX_MEMORY * sizeof(memory_t));
     for (int i = 0; i < MAX_MEMORY; i++) {
-        memory[i] = malloc(sizeof(memory_t));
-        memory[i]->index = i;
-        memory[i]->is_allocated = 0;
+        memory->blocks[i] = &storage[i];
+        memory->blocks[i]->index = i;
+        memory->blocks[i]->is_allocated = 0;
     }
 
+    // whole memory starts as one hole
+    add_hole(memory, 0, MAX_MEMORY);
+
     return memory;
 }
 
 
-// Allocate memory for specific size
-int allocate_mem(memory_t **memory, int size) {
-
-    int min_mem_diff = INT_MAX;
-    int min_start_index = -1;
+// Find start of smallest hole fitting size, lowest address on ties
+// return -1 when none fits, nothing is allocated
+int find_best_fit(mem_table_t *memory, int size) {
 
-    // traverse mem region finding fittest
-    for (int i = 0; i < MAX_MEMORY; i++) {
-        if (!memory[i]->is_allocated) {
-            int j;
-            for (j = i; j < MAX_MEMORY; j++) {
-                if (!memory[j]->is_allocated) {
-                    continue;
-                };
-                break;
-            }
+    if (size > memory->largest_hole) return -1;
 
-            int mem_diff = j - i;
-            if (mem_diff >= size && mem_diff < min_mem_diff) {
-                min_mem_diff = mem_diff;
-                min_start_index = i;
-            }
+    // smallest hole size in use not below size
+    int word = size / 64;
+    uint64_t bits = memory->size_bits[word] & (~(uint64_t)0 << (size % 64));
+    while (bits == 0) bits = memory->size_bits[++word];
+    int fit = word * 64 + __builtin_ctzll(bits);
 
-            i = j - 1;
+    // first hole of that size in address order
+    for (word = 0; word < HOLE_WORDS; word++) {
+        bits = memory->start_bits[word];
+        while (bits != 0) {
+            int start = word * 64 + __builtin_ctzll(bits);
+            if (memory->blocks[start]->run == fit) return start;
+            bits &= bits - 1;
         }
     }
+    return -1;
+}
+
+
+// Allocate memory for specific size
+int allocate_mem(mem_table_t *memory, int size) {
 
     // falied to alloc mem
-    if (min_start_index != -1) {
-        for (int i = min_start_index; i < min_start_index + size; i++) {
-            memory[i]->is_allocated = 1;
+    int start = find_best_fit(memory, size);
+    if (start == -1) {
+        memory->failed++;
+        return start;
+    }
+
+    take_hole(memory, start, size);
+
+    return start;
+
+}
+
+
+// Count how many of the given allocations must be freed, in order,
+// before a hole fits size, while hold_size blocks at hold_start stay
+// taken from the front of their hole, memory itself is left alone
+// return -1 when size does not fit even with all of them freed
+int frees_to_fit(mem_table_t *memory, int count, int *starts, int *sizes, 
+                 int hold_start, int hold_size, int size) {
+
+    // free map and hole lengths tagged at both ends, as in the table
+    uint8_t taken[MAX_MEMORY];
+    int run[MAX_MEMORY];
+    memset(taken, 1, sizeof(taken));
+    int largest = 0;
+    for (int word = 0; word < HOLE_WORDS; word++) {
+        uint64_t bits = memory->start_bits[word];
+        while (bits != 0) {
+            int start = word * 64 + __builtin_ctzll(bits);
+            int length = memory->blocks[start]->run;
+            bits &= bits - 1;
+            if (start == hold_start) {
+                start += hold_size;
+                length -= hold_size;
+                if (length == 0) continue;
+            }
+            memset(taken + start, 0, length);
+            run[start] = length;
+            run[start + length - 1] = length;
+            if (length > largest) largest = length;
         }
     }
 
-    return min_start_index;
+    // merge each freed allocation with its neighbours
+    int freed = 0;
+    while (largest < size && freed < count) {
+        int start = starts[freed];
+        int length = sizes[freed];
+        freed++;
+        if (start < 0) continue;
+        memset(taken + start, 0, length);
+        if (start > 0 && !taken[start - 1]) {
+            int left = run[start - 1];
+            start -= left;
+            length += left;
+        }
+        if (start + length < MAX_MEMORY && !taken[start + length]) {
+            length += run[start + length];
+        }
+        run[start] = length;
+        run[start + length - 1] = length;
+        if (length > largest) largest = length;
+    }
 
+    if (largest < size) return -1;
+    return freed;
 }
 
 
 // Clear memory blocks with specific starts and size
-void clear_mem(memory_t **memory, int start, int size) {
+void clear_mem(mem_table_t *memory, int start, int size) {
+
+    memory_t **blocks = memory->blocks;
+    if (start < 0) return;
+
     for (int i = start; i < start + size; i++) {
-        memory[i]->is_allocated = 0;
+        blocks[i]->is_allocated = 0;
+    }
+
+    // merge with neighbouring holes using their boundary tags
+    int hole_start = start;
+    int hole_size = size;
+    if (start > 0 && !blocks[start - 1]->is_allocated) {
+        int left = blocks[start - 1]->run;
+        remove_hole(memory, start - left, left);
+        hole_start -= left;
+        hole_size += left;
+    }
+    if (start + size < MAX_MEMORY && !blocks[start + size]->is_allocated) {
+        int right = blocks[start + size]->run;
+        remove_hole(memory, start + size, right);
+        hole_size += right;
     }
+    add_hole(memory, hole_start, hole_size);
+
+    memory->live -= size;
+    track_peaks(memory);
 }
 
 
-// Free system memory when allocating blocks
-void free_mem(memory_t **memory) {
+// Slide unpinned allocations down to merge holes
+// return largest hole left, only moving blocks when apply is set
+int compact_mem(mem_table_t *memory, int count, int *starts, int *sizes, 
+                int *pinned, int apply, int *moved) {
+
+    // find allocations in address order
+    int owner[MAX_MEMORY];
     for (int i = 0; i < MAX_MEMORY; i++) {
-        free(memory[i]);
+        owner[i] = -1;
     }
-    free(memory);
+    for (int k = 0; k < count; k++) {
+        if (starts[k] >= 0) owner[starts[k]] = k;
+    }
+
+    int cursor = 0;
+    int largest = 0;
+    *moved = 0;
+    for (int i = 0; i < MAX_MEMORY; i++) {
+        int k = owner[i];
+        if (k == -1) continue;
+
+        // pinned allocation closes the hole before it
+        if (pinned[k]) {
+            if (i - cursor > largest) largest = i - cursor;
+            cursor = i + sizes[k];
+            continue;
+        }
+
+        // everything between cursor and this allocation is free
+        if (i > cursor) {
+            *moved += sizes[k];
+            if (apply) {
+                clear_mem(memory, i, sizes[k]);
+                take_hole(memory, cursor, sizes[k]);
+                memory->relocated += sizes[k];
+                starts[k] = cursor;
+            }
+        }
+        cursor += sizes[k];
+    }
+    if (MAX_MEMORY - cursor > largest) largest = MAX_MEMORY - cursor;
+
+    return largest;
+}
+
+
+// Accumulate memory usage up to given time, before memory changes
+void sample_mem(mem_table_t *memory, long long time) {
+    if (time > memory->last_time) {
+        long long elapsed = time - memory->last_time;
+        memory->live_area += memory->live * elapsed;
+        memory->fragmentation_area += get_mem_fragmentation(memory) * 
+                                      elapsed;
+        memory->last_time = time;
+    }
+}
+
+
+// Get memory currently allocated
+int get_mem_live(mem_table_t *memory) {
+    return memory->live;
+}
+
+
+// Get highest memory allocated at once
+int get_mem_peak(mem_table_t *memory) {
+    return memory->peak;
+}
+
+
+// Get number of free holes
+int get_mem_holes(mem_table_t *memory) {
+    return memory->holes;
+}
+
+
+// Get highest number of free holes at once
+int get_mem_max_holes(mem_table_t *memory) {
+    return memory->max_holes;
+}
+
+
+// Get number of blocks moved by compaction
+int get_mem_relocated(mem_table_t *memory) {
+    return memory->relocated;
+}
+
+
+// Get size of largest free hole
+int get_mem_largest_hole(mem_table_t *memory) {
+    return memory->largest_hole;
+}
+
+
+// Get number of allocations which found no fitting hole
+int get_mem_failed(mem_table_t *memory) {
+    return memory->failed;
+}
+
+
+// Get share of free memory unusable by a request of all free memory
+double get_mem_fragmentation(mem_table_t *memory) {
+    int free_size = MAX_MEMORY - memory->live;
+    if (free_size == 0) return 0.0;
+    return 1.0 - (double)memory->largest_hole / free_size;
+}
+
+
+// Get highest fragmentation seen so far
+double get_mem_max_fragmentation(mem_table_t *memory) {
+    return memory->max_fragmentation;
+}
+
+
+// Get time weighted average fragmentation up to last sample
+double get_mem_avg_fragmentation(mem_table_t *memory) {
+    if (memory->last_time == 0) return 0.0;
+    return memory->fragmentation_area / memory->last_time;
+}
+
+
+// Get average share of memory allocated up to last sample
+double get_mem_utilisation(mem_table_t *memory) {
+    if (memory->last_time == 0) return 0.0;
+    return (double)memory->live_area /
+           ((double)memory->last_time * MAX_MEMORY);
+}
+
+
+// Write holes and statistics, allocations are what holes leave out
+void save_mem(mem_table_t *memory, FILE *file) {
+
+    fwrite(&memory->holes, sizeof(int), 1, file);
+    for (int i = 0; i < MAX_MEMORY; i++) {
+        if (memory->blocks[i]->is_allocated) continue;
+        int hole[2] = {i, memory->blocks[i]->run};
+        fwrite(hole, sizeof(int), 2, file);
+        i += hole[1] - 1;
+    }
+
+    fwrite(&memory->live, sizeof(int), 1, file);
+    fwrite(&memory->peak, sizeof(int), 1, file);
+    fwrite(&memory->max_holes, sizeof(int), 1, file);
+    fwrite(&memory->failed, sizeof(int), 1, file);
+    fwrite(&memory->relocated, sizeof(int), 1, file);
+    fwrite(&memory->max_fragmentation, sizeof(double), 1, file);
+    fwrite(&memory->last_time, sizeof(long long), 1, file);
+    fwrite(&memory->live_area, sizeof(long long), 1, file);
+    fwrite(&memory->fragmentation_area, sizeof(double), 1, file);
+}
+
+
+// Read memory written by save_mem into a fresh table
+// return 0 when holes do not fit in memory
+int load_mem(mem_table_t *memory, FILE *file) {
+
+    // start fully allocated and carve out the holes
+    int holes = 0;
+    fread(&holes, sizeof(int), 1, file);
+    for (int i = 0; i < MAX_MEMORY; i++) {
+        memory->blocks[i]->is_allocated = 1;
+    }
+    memset(memory->hole_sizes, 0, sizeof(memory->hole_sizes));
+    memset(memory->start_bits, 0, sizeof(memory->start_bits));
+    memset(memory->size_bits, 0, sizeof(memory->size_bits));
+    memory->holes = 0;
+    memory->largest_hole = 0;
+    for (int k = 0; k < holes; k++) {
+        int hole[2] = {0, 0};
+        fread(hole, sizeof(int), 2, file);
+        if (hole[0] < 0 || hole[1] < 1 || hole[0] + hole[1] > MAX_MEMORY) {
+            return 0;
+        }
+        for (int i = hole[0]; i < hole[0] + hole[1]; i++) {
+            memory->blocks[i]->is_allocated = 0;
+        }
+        add_hole(memory, hole[0], hole[1]);
+    }
+
+    fread(&memory->live, sizeof(int), 1, file);
+    fread(&memory->peak, sizeof(int), 1, file);
+    fread(&memory->max_holes, sizeof(int), 1, file);
+    fread(&memory->failed, sizeof(int), 1, file);
+    fread(&memory->relocated, sizeof(int), 1, file);
+    fread(&memory->max_fragmentation, sizeof(double), 1, file);
+    fread(&memory->last_time, sizeof(long long), 1, file);
+    fread(&memory->live_area, sizeof(long long), 1, file);
+    fread(&memory->fragmentation_area, sizeof(double), 1, file);
+
+    return 1;
 }
\ No newline at end of file
@@ -2,18 +2,58 @@
 #define _MEMORY_H_
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "arena.h"
 
 #define MAX_MEMORY 2048
 
 typedef struct memory memory_t;
+typedef struct mem_table mem_table_t;
+
+mem_table_t *create_mem_table(arena_t *arena);
+
+int find_best_fit(mem_table_t *memory, int size);
+
+int allocate_mem(mem_table_t *memory, int size);
+
+int frees_to_fit(mem_table_t *memory, int count, int *starts, int *sizes, 
+                 int hold_start, int hold_size, int size);
+
+void clear_mem(mem_table_t *memory, int start, int size);
+
+int compact_mem(mem_table_t *memory, int count, int *starts, int *sizes, 
+                int *pinned, int apply, int *moved);
+
+void sample_mem(mem_table_t *memory, long long time);
+
+int get_mem_live(mem_table_t *memory);
+
+int get_mem_peak(mem_table_t *memory);
+
+int get_mem_holes(mem_table_t *memory);
+
+int get_mem_max_holes(mem_table_t *memory);
+
+int get_mem_largest_hole(mem_table_t *memory);
+
+int get_mem_relocated(mem_table_t *memory);
+
+int get_mem_failed(mem_table_t *memory);
+
+double get_mem_fragmentation(mem_table_t *memory);
+
+double get_mem_max_fragmentation(mem_table_t *memory);
 
-memory_t **create_mem_table();
+double get_mem_avg_fragmentation(mem_table_t *memory);
 
-int allocate_mem(memory_t **memory, int size);
+double get_mem_utilisation(mem_table_t *memory);
 
-void clear_mem(memory_t **memory, int start, int size);
+void save_mem(mem_table_t *memory, FILE *file);
 
-void free_mem(memory_t **memory);
+int load_mem(mem_table_t *memory, FILE *file);
 
 #endif
\ No newline at end of file
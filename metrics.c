@@ -0,0 +1,190 @@
+#include "metrics.h"
+
+#define RATE_WINDOW_NS 1000000000LL
+
+struct metrics
+{
+    int fd;
+    metrics_page_t *page;
+
+    // events per second over the last full window
+    int64_t window_ns;
+    int64_t window_events;
+    double rate;
+
+    // handshake latency, kept here and published with the rest
+    int64_t handshakes;
+    double mean;
+    int64_t last;
+    int64_t max;
+};
+
+
+// Get monotonic clock in nanoseconds
+int64_t metrics_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+// Create metrics file at path and map it for updates
+metrics_t *open_metrics(char *path, arena_t *arena) {
+
+    metrics_t *metrics = arena_calloc(arena, 1, sizeof(metrics_t));
+    metrics->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 
+                       0644);
+    if (metrics->fd == -1 || 
+        ftruncate(metrics->fd, sizeof(metrics_page_t)) == -1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    metrics->page = mmap(NULL, sizeof(metrics_page_t), 
+                         PROT_READ | PROT_WRITE, MAP_SHARED, metrics->fd, 0);
+    if (metrics->page == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    // file reads as zeros until the header marks it ready
+    int64_t now = metrics_clock();
+    metrics->page->version = METRICS_VERSION;
+    metrics->page->started_ns = now;
+    metrics->page->updated_ns = now;
+    metrics->window_ns = now;
+    __atomic_store_n(&metrics->page->magic, METRICS_MAGIC, 
+                     __ATOMIC_RELEASE);
+
+    return metrics;
+}
+
+
+// Account one handshake taking ns of wall clock
+void record_handshake(metrics_t *metrics, int64_t ns) {
+    metrics->handshakes++;
+    metrics->mean += (ns - metrics->mean) / metrics->handshakes;
+    metrics->last = ns;
+    if (ns > metrics->max) metrics->max = ns;
+}
+
+
+// Copy fields that change during the run one whole 8 byte field at a
+// time, as the other side of the seqlock may be in another process
+// touching them at once, plain stores or memcpy could be torn
+static void copy_payload(metrics_page_t *to, metrics_page_t *from) {
+#define COPY_FIELD(field) \
+    do { \
+        __typeof__(from->field) value; \
+        __atomic_load(&from->field, &value, __ATOMIC_RELAXED); \
+        __atomic_store(&to->field, &value, __ATOMIC_RELAXED); \
+    } while (0)
+
+    COPY_FIELD(updated_ns);
+    COPY_FIELD(done);
+    COPY_FIELD(events);
+    COPY_FIELD(finished);
+    COPY_FIELD(handshakes);
+    COPY_FIELD(time);
+    COPY_FIELD(ready);
+    COPY_FIELD(waiting);
+    COPY_FIELD(live_children);
+    COPY_FIELD(mem_used);
+    COPY_FIELD(largest_hole);
+    COPY_FIELD(events_per_sec);
+    COPY_FIELD(handshake_mean_ns);
+    COPY_FIELD(handshake_last_ns);
+    COPY_FIELD(handshake_max_ns);
+#undef COPY_FIELD
+}
+
+
+// Write counters and gauges in values to the file, filling in the rest
+// never waits on readers
+void publish_metrics(metrics_t *metrics, metrics_page_t *values) {
+
+    metrics_page_t *page = metrics->page;
+    int64_t now = metrics_clock();
+    if (now - metrics->window_ns >= RATE_WINDOW_NS) {
+        metrics->rate = (values->events - metrics->window_events) * 1e9 / 
+                        (now - metrics->window_ns);
+        metrics->window_ns = now;
+        metrics->window_events = values->events;
+    }
+
+    // odd seq tells readers an update is under way
+    uint64_t seq = page->seq;
+    __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    values->updated_ns = now;
+    values->events_per_sec = metrics->rate;
+    values->handshakes = metrics->handshakes;
+    values->handshake_mean_ns = metrics->mean;
+    values->handshake_last_ns = metrics->last;
+    values->handshake_max_ns = metrics->max;
+    copy_payload(page, values);
+
+    __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+
+// Unmap metrics file, which keeps the last values written
+void close_metrics(metrics_t *metrics) {
+    munmap(metrics->page, sizeof(metrics_page_t));
+    close(metrics->fd);
+}
+
+
+// Print a consistent snapshot of the metrics file at path
+// return 0 when it can not be read
+int read_metrics(char *path, FILE *out) {
+
+    // a short or foreign file would fault when read past its end
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return 0;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || 
+        st.st_size < (off_t)sizeof(metrics_page_t)) {
+        close(fd);
+        return 0;
+    }
+    metrics_page_t *page = mmap(NULL, sizeof(metrics_page_t), PROT_READ, 
+                                MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) return 0;
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC || 
+        page->version != METRICS_VERSION) {
+        munmap(page, sizeof(metrics_page_t));
+        return 0;
+    }
+
+    // copy until no update overlapped the copy, started_ns is only
+    // written before magic
+    metrics_page_t snap;
+    snap.started_ns = page->started_ns;
+    uint64_t before, after;
+    do {
+        before = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        copy_payload(&snap, page);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&page->seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+    munmap(page, sizeof(metrics_page_t));
+
+    fprintf(out, "state %s\nuptime_ms %.1lf\n", 
+            snap.done ? "done" : "running", 
+            (snap.updated_ns - snap.started_ns) / 1e6);
+    fprintf(out, "time %lld\nevents %lld\nevents_per_sec %.1lf\n"
+            "finished %lld\n", (long long)snap.time, 
+            (long long)snap.events, snap.events_per_sec, 
+            (long long)snap.finished);
+    fprintf(out, "ready %lld\nwaiting %lld\nlive_children %lld\n"
+            "mem_used %lld\nlargest_hole %lld\n", (long long)snap.ready, 
+            (long long)snap.waiting, (long long)snap.live_children, 
+            (long long)snap.mem_used, (long long)snap.largest_hole);
+    fprintf(out, "handshakes %lld\nhandshake_ns %lld %.1lf %lld\n", 
+            (long long)snap.handshakes, (long long)snap.handshake_last_ns, 
+            snap.handshake_mean_ns, (long long)snap.handshake_max_ns);
+
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+
+#define METRICS_MAGIC 0x4d455452
+#define METRICS_VERSION 1
+
+typedef struct metrics metrics_t;
+
+// Layout of the metrics file, rewritten in place while the run goes on
+// seq is odd while an update is being written, readers retry until
+// they see the same even seq before and after copying
+// every field after the header words is 8 bytes and 8 byte aligned,
+// so each is loaded and stored whole with relaxed atomics
+typedef struct metrics_page {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seq;
+    int64_t started_ns;
+    int64_t updated_ns;
+    int64_t done;
+
+    // counters
+    int64_t events;
+    int64_t finished;
+    int64_t handshakes;
+
+    // gauges
+    int64_t time;
+    int64_t ready;
+    int64_t waiting;
+    int64_t live_children;
+    int64_t mem_used;
+    int64_t largest_hole;
+    double events_per_sec;
+    double handshake_mean_ns;
+    int64_t handshake_last_ns;
+    int64_t handshake_max_ns;
+} metrics_page_t;
+
+metrics_t *open_metrics(char *path, arena_t *arena);
+
+int64_t metrics_clock(void);
+
+void record_handshake(metrics_t *metrics, int64_t ns);
+
+void publish_metrics(metrics_t *metrics, metrics_page_t *values);
+
+void close_metrics(metrics_t *metrics);
+
+int read_metrics(char *path, FILE *out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "pace.h"
+
+struct pacer
+{
+    int fd;
+    long long unit_ns;
+
+    // wall clock and simulated time the pacer started at
+    long long start_ns;
+    long long start_time;
+
+    // lateness of each wakeup past its deadline, running mean and
+    // squared deviations for jitter
+    long long ticks;
+    long long missed;
+    double mean;
+    double squares;
+    double max;
+};
+
+
+// Get monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+// Create pacer mapping each time unit to unit_ns of wall clock, with
+// the given simulated time as now
+pacer_t *create_pacer(long long unit_ns, long long time, arena_t *arena) {
+    pacer_t *pacer = arena_calloc(arena, 1, sizeof(pacer_t));
+    pacer->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (pacer->fd == -1) {
+        perror("timerfd_create");
+        exit(EXIT_FAILURE);
+    }
+    pacer->unit_ns = unit_ns;
+    pacer->start_ns = now_ns();
+    pacer->start_time = time;
+    return pacer;
+}
+
+
+// Get wall clock deadline of simulated time, in 128 bits so day scale
+// times at coarse units can not overflow, as late as the clock goes
+static long long get_deadline(pacer_t *pacer, long long time) {
+    __int128 deadline = pacer->start_ns + 
+                        (__int128)(time - pacer->start_time) * pacer->unit_ns;
+    return deadline < LLONG_MAX ? (long long)deadline : LLONG_MAX;
+}
+
+
+// Sleep until wall clock deadline of simulated time, keeping lateness
+void pace_until(pacer_t *pacer, long long time) {
+
+    long long deadline = get_deadline(pacer, time);
+    if (now_ns() >= deadline) {
+        pacer->missed++;
+    } else {
+        struct itimerspec spec = {{0, 0}, 
+                                  {deadline / 1000000000LL, 
+                                   deadline % 1000000000LL}};
+        timerfd_settime(pacer->fd, TFD_TIMER_ABSTIME, &spec, NULL);
+        uint64_t expired;
+        read(pacer->fd, &expired, sizeof(expired));
+    }
+
+    // Welford's update of mean and squared deviations
+    double late = now_ns() - deadline;
+    pacer->ticks++;
+    double delta = late - pacer->mean;
+    pacer->mean += delta / pacer->ticks;
+    pacer->squares += delta * (late - pacer->mean);
+    if (late > pacer->max) pacer->max = late;
+}
+
+
+// Close timer, statistics stay readable
+void close_pacer(pacer_t *pacer) {
+    close(pacer->fd);
+}
+
+
+// Get number of deadlines paced
+long long get_pace_ticks(pacer_t *pacer) {
+    return pacer->ticks;
+}
+
+
+// Get number of deadlines already passed when reached
+long long get_pace_missed(pacer_t *pacer) {
+    return pacer->missed;
+}
+
+
+// Get mean lateness in microseconds
+double get_pace_drift(pacer_t *pacer) {
+    return pacer->mean / 1000;
+}
+
+
+// Get highest lateness in microseconds
+double get_pace_max_drift(pacer_t *pacer) {
+    return pacer->max / 1000;
+}
+
+
+// Get standard deviation of lateness in microseconds
+double get_pace_jitter(pacer_t *pacer) {
+    if (pacer->ticks < 2) return 0.0;
+    return sqrt(pacer->squares / (pacer->ticks - 1)) / 1000;
+}
\ No newline at end of file
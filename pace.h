@@ -0,0 +1,33 @@
+#ifndef _PACE_H_
+#define _PACE_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "arena.h"
+
+typedef struct pacer pacer_t;
+
+pacer_t *create_pacer(long long unit_ns, long long time, arena_t *arena);
+
+void pace_until(pacer_t *pacer, long long time);
+
+void close_pacer(pacer_t *pacer);
+
+long long get_pace_ticks(pacer_t *pacer);
+
+long long get_pace_missed(pacer_t *pacer);
+
+double get_pace_drift(pacer_t *pacer);
+
+double get_pace_max_drift(pacer_t *pacer);
+
+double get_pace_jitter(pacer_t *pacer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "paging.h"
+
+struct page_table
+{
+    int n;
+
+    // frames as linked lists, one free list and one per process
+    int *owner;
+    int *next_frame;
+    int free_head;
+    int free_count;
+    int *first_frame;
+    int *resident;
+
+    // processes holding frames, least recently run first
+    int *prev;
+    int *next;
+    int head;
+    int tail;
+
+    long long faults;
+    long long loaded;
+    long long evicted;
+    long long time;
+};
+
+
+// Create page table with every frame free
+page_table_t *create_page_table(int n, arena_t *arena) {
+    page_table_t *table = arena_calloc(arena, 1, sizeof(page_table_t));
+    table->n = n;
+    table->owner = arena_alloc(arena, NUM_FRAMES * sizeof(int));
+    table->next_frame = arena_alloc(arena, NUM_FRAMES * sizeof(int));
+    for (int f = 0; f < NUM_FRAMES; f++) {
+        table->owner[f] = -1;
+        table->next_frame[f] = f + 1 < NUM_FRAMES ? f + 1 : -1;
+    }
+    table->free_head = 0;
+    table->free_count = NUM_FRAMES;
+
+    table->first_frame = arena_alloc(arena, n * sizeof(int));
+    table->resident = arena_calloc(arena, n, sizeof(int));
+    table->prev = arena_alloc(arena, n * sizeof(int));
+    table->next = arena_alloc(arena, n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        table->first_frame[i] = -1;
+        table->prev[i] = -2;
+    }
+    table->head = -1;
+    table->tail = -1;
+
+    return table;
+}
+
+
+// Get number of pages covering memory size
+int get_page_count(int size) {
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+
+// Get number of pages process has in frames
+int get_resident_pages(page_table_t *table, int index) {
+    return table->resident[index];
+}
+
+
+// Get number of frames nobody holds
+int get_free_frames(page_table_t *table) {
+    return table->free_count;
+}
+
+
+// Take process out of the recency list, prev of -2 marks it absent
+static void unlink_process(page_table_t *table, int index) {
+    if (table->prev[index] == -2) return;
+    if (table->prev[index] != -1) {
+        table->next[table->prev[index]] = table->next[index];
+    } else {
+        table->head = table->next[index];
+    }
+    if (table->next[index] != -1) {
+        table->prev[table->next[index]] = table->prev[index];
+    } else {
+        table->tail = table->prev[index];
+    }
+    table->prev[index] = -2;
+}
+
+
+// Mark process as most recently run
+void touch_process(page_table_t *table, int index) {
+    unlink_process(table, index);
+    table->prev[index] = table->tail;
+    table->next[index] = -1;
+    if (table->tail != -1) {
+        table->next[table->tail] = index;
+    } else {
+        table->head = index;
+    }
+    table->tail = index;
+}
+
+
+// Get least recently run process, -1 when none holds frames
+int get_lru_process(page_table_t *table) {
+    return table->head;
+}
+
+
+// Free up to count frames of process
+// return number freed, dropping the process from the list once empty
+int evict_pages(page_table_t *table, int index, int count) {
+    int freed = 0;
+    while (freed < count && table->first_frame[index] != -1) {
+        int f = table->first_frame[index];
+        table->first_frame[index] = table->next_frame[f];
+        table->owner[f] = -1;
+        table->next_frame[f] = table->free_head;
+        table->free_head = f;
+        freed++;
+    }
+    table->resident[index] -= freed;
+    table->free_count += freed;
+    table->evicted += freed;
+    if (table->resident[index] == 0) unlink_process(table, index);
+    return freed;
+}
+
+
+// Give process count free frames, there must be enough
+void load_pages(page_table_t *table, int index, int count) {
+    for (int k = 0; k < count; k++) {
+        int f = table->free_head;
+        table->free_head = table->next_frame[f];
+        table->owner[f] = index;
+        table->next_frame[f] = table->first_frame[index];
+        table->first_frame[index] = f;
+    }
+    table->resident[index] += count;
+    table->free_count -= count;
+    table->loaded += count;
+    table->faults++;
+}
+
+
+// Release every frame of finished process
+void free_pages(page_table_t *table, int index) {
+    long long evicted = table->evicted;
+    evict_pages(table, index, table->resident[index]);
+    table->evicted = evicted;
+    unlink_process(table, index);
+}
+
+
+// Get number of runs which had to load pages
+long long get_page_faults(page_table_t *table) {
+    return table->faults;
+}
+
+
+// Get number of pages loaded into frames
+long long get_pages_loaded(page_table_t *table) {
+    return table->loaded;
+}
+
+
+// Get number of pages evicted for another process
+long long get_pages_evicted(page_table_t *table) {
+    return table->evicted;
+}
+
+
+// Account time the clock spent on faults and evictions
+void charge_page_time(page_table_t *table, long long time) {
+    table->time += time;
+}
+
+
+// Get time the clock spent on faults and evictions
+long long get_page_time(page_table_t *table) {
+    return table->time;
+}
+
+
+// Write frame lists, recency list and counters
+void save_page_table(page_table_t *table, FILE *file) {
+    int n = table->n;
+    fwrite(table->owner, sizeof(int), NUM_FRAMES, file);
+    fwrite(table->next_frame, sizeof(int), NUM_FRAMES, file);
+    fwrite(&table->free_head, sizeof(int), 1, file);
+    fwrite(&table->free_count, sizeof(int), 1, file);
+    fwrite(table->first_frame, sizeof(int), n, file);
+    fwrite(table->resident, sizeof(int), n, file);
+    fwrite(table->prev, sizeof(int), n, file);
+    fwrite(table->next, sizeof(int), n, file);
+    fwrite(&table->head, sizeof(int), 1, file);
+    fwrite(&table->tail, sizeof(int), 1, file);
+    fwrite(&table->faults, sizeof(long long), 1, file);
+    fwrite(&table->loaded, sizeof(long long), 1, file);
+    fwrite(&table->evicted, sizeof(long long), 1, file);
+    fwrite(&table->time, sizeof(long long), 1, file);
+}
+
+
+// Read page table written by save_page_table
+// return 0 when frame counts are out of range
+int load_page_table(page_table_t *table, FILE *file) {
+    int n = table->n;
+    fread(table->owner, sizeof(int), NUM_FRAMES, file);
+    fread(table->next_frame, sizeof(int), NUM_FRAMES, file);
+    fread(&table->free_head, sizeof(int), 1, file);
+    fread(&table->free_count, sizeof(int), 1, file);
+    if (table->free_count < 0 || table->free_count > NUM_FRAMES) return 0;
+    fread(table->first_frame, sizeof(int), n, file);
+    fread(table->resident, sizeof(int), n, file);
+    fread(table->prev, sizeof(int), n, file);
+    fread(table->next, sizeof(int), n, file);
+    fread(&table->head, sizeof(int), 1, file);
+    fread(&table->tail, sizeof(int), 1, file);
+    fread(&table->faults, sizeof(long long), 1, file);
+    fread(&table->loaded, sizeof(long long), 1, file);
+    fread(&table->evicted, sizeof(long long), 1, file);
+    fread(&table->time, sizeof(long long), 1, file);
+    return 1;
+}
\ No newline at end of file
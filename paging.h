@@ -0,0 +1,48 @@
+#ifndef _PAGING_H_
+#define _PAGING_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "memory.h"
+
+#define PAGE_SIZE 4
+#define NUM_FRAMES (MAX_MEMORY / PAGE_SIZE)
+
+typedef struct page_table page_table_t;
+
+page_table_t *create_page_table(int n, arena_t *arena);
+
+int get_page_count(int size);
+
+int get_resident_pages(page_table_t *table, int index);
+
+int get_free_frames(page_table_t *table);
+
+void touch_process(page_table_t *table, int index);
+
+int get_lru_process(page_table_t *table);
+
+int evict_pages(page_table_t *table, int index, int count);
+
+void load_pages(page_table_t *table, int index, int count);
+
+void free_pages(page_table_t *table, int index);
+
+long long get_page_faults(page_table_t *table);
+
+long long get_pages_loaded(page_table_t *table);
+
+long long get_pages_evicted(page_table_t *table);
+
+void charge_page_time(page_table_t *table, long long time);
+
+long long get_page_time(page_table_t *table);
+
+void save_page_table(page_table_t *table, FILE *file);
+
+int load_page_table(page_table_t *table, FILE *file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,558 @@
+#include "policy.h"
+
+
+// Get next process arrived by now not yet given to policy
+static int next_arrived(run_t *run) {
+    if (run->fed < run->n && 
+        run->arrival[run->order[run->fed % run->capacity]] <= *run->time) {
+        return run->order[run->fed++ % run->capacity];
+    }
+    return -1;
+}
+
+
+// Take processes arrived by now into the service time heap
+static void sjf_admit(run_t *run) {
+    int i;
+    while ((i = next_arrived(run)) != -1) {
+        push_heap(run->heap, i, get_service_time(run->p[i]), i);
+    }
+}
+
+
+// Keep running current process, else pick shortest which has memory
+static int sjf_pick_next(run_t *run) {
+
+    if (run->current != -1) return run->current;
+
+    // alloc mem when using best-fit, leaving those which do not fit
+    int skipped = 0;
+    int *held = run->admitted;
+    int i;
+    while ((i = pop_heap(run->heap)) != -1) {
+        if (run->mem_allocated[i]) break;
+
+        // paged memory takes any process not above every frame
+        if (run->memory == NULL) {
+            if (can_hold(run, run->size[i])) break;
+            held[skipped++] = i;
+            continue;
+        }
+
+        sample_mem(run->memory, *run->time);
+        run->memstart[i] = allocate_mem(run->memory, run->size[i]);
+        if (run->memstart[i] != -1) {
+            remove_waiting(run->queue, i);
+            print_ready_msg(run->out, *run->time, get_process_name(run->p[i]), 
+                            run->memstart[i]);
+            if (run->opts->mem_sample) {
+                print_mem_msg(run->out, *run->time, run->memory);
+            }
+            run->mem_allocated[i] = 1;
+            break;
+        }
+        held[skipped++] = i;
+    }
+
+    // put back those left waiting for memory
+    for (int k = 0; k < skipped; k++) {
+        push_heap(run->heap, held[k], get_service_time(run->p[held[k]]), 
+                  held[k]);
+    }
+
+    run->current = i;
+    return i;
+}
+
+
+// Give memory to processes ready while this one ran
+static void sjf_on_finish(run_t *run, int i) {
+
+    run->current = -1;
+    if (run->memory == NULL) return;
+
+    mem_table_t *memory = run->memory;
+    wait_queue_t *queue = run->queue;
+    admit_arrivals(queue, *run->time - run->opts->quantum);
+    sample_mem(memory, *run->time);
+
+    // alloc those which fit in arrival order, holes only shrink so the
+    // next is always the earliest fitting the largest hole
+    // print process ready message
+    int k;
+    while ((k = first_fitting(queue, get_mem_largest_hole(memory))) != -1) {
+        run->memstart[k] = allocate_mem(memory, run->size[k]);
+        remove_waiting(queue, k);
+        print_ready_msg(run->out, run->arrival[k], 
+                        get_process_name(run->p[k]), run->memstart[k]);
+        if (run->opts->mem_sample) {
+            print_mem_msg(run->out, run->arrival[k], memory);
+        }
+        run->mem_allocated[k] = 1;
+    }
+}
+
+
+// Give memory to arrived processes, they are found by the scan
+static void rr_admit(run_t *run) {
+    admit_waiting(run);
+}
+
+
+// Find next arrived process with memory, cycling from last position
+static int rr_pick_next(run_t *run) {
+    int i = find_eligible(run->arrival, run->is_finished, run->mem_allocated, 
+                          run->cursor, run->slots, *run->time);
+    if (i == -1) {
+        i = find_eligible(run->arrival, run->is_finished, 
+                          run->mem_allocated, 0, run->cursor, *run->time);
+    }
+    if (i != -1) run->cursor = i + 1;
+    return i;
+}
+
+
+// Check for another arrived process with memory
+static int rr_contended(run_t *run, int i) {
+    return find_eligible(run->arrival, run->is_finished, run->mem_allocated, 
+                         0, i, *run->time) != -1 || 
+           find_eligible(run->arrival, run->is_finished, run->mem_allocated, 
+                         i + 1, run->slots, *run->time) != -1;
+}
+
+
+// Start the scan over once memory is freed
+static void rr_on_finish(run_t *run, int i) {
+    if (run->memory != NULL) run->cursor = 0;
+}
+
+
+// Count quanta new arrivals need, forgetting older ones by halves
+static void arr_admit(run_t *run) {
+
+    options_t *opts = run->opts;
+    long long q = opts->quantum;
+    int i;
+    while ((i = next_arrived(run)) != -1) {
+        long long service = get_service_time(run->p[i]);
+        long long need = service / q + (service % q != 0);
+        if (need > opts->slice_max) need = opts->slice_max;
+        run->service_quanta[need]++;
+        if (++run->service_count == SLICE_WINDOW) {
+            run->service_count = 0;
+            for (int k = 0; k <= opts->slice_max; k++) {
+                run->service_quanta[k] /= 2;
+                run->service_count += run->service_quanta[k];
+            }
+        }
+    }
+    run->slice_ready += admit_waiting(run);
+}
+
+
+// Choose slice most arrivals finish within, shrunk so a round of the
+// ready processes stays within a few of the longest slices
+static int adapt_slice(run_t *run) {
+
+    options_t *opts = run->opts;
+    int slice = opts->slice_max;
+    int seen = 0;
+    for (int k = 1; k <= opts->slice_max; k++) {
+        seen += run->service_quanta[k];
+        if (seen * 100 >= run->service_count * SLICE_PERCENTILE) {
+            slice = k;
+            break;
+        }
+    }
+
+    int ready = run->slice_ready;
+    if (ready > 0 && slice * ready > opts->slice_max * SLICE_ROUND) {
+        slice = opts->slice_max * SLICE_ROUND / ready;
+    }
+    if (slice < opts->slice_min) slice = opts->slice_min;
+    return slice;
+}
+
+
+// Keep current process for its slice, then move on as RR does
+// with a slice chosen afresh
+static int arr_pick_next(run_t *run) {
+
+    int i = run->current;
+    if (i != -1 && run->slice_used < run->slice) return i;
+
+    i = rr_pick_next(run);
+    if (i != -1) {
+        int slice = adapt_slice(run);
+        if (slice != run->slice) {
+            run->slice = slice;
+            print_quantum_msg(run->out, *run->time, 
+                              slice * run->opts->quantum, run->slice_ready);
+        }
+        run->slice_used = 0;
+    }
+    run->current = i;
+    return i;
+}
+
+
+// Another process may take over once the slice's last quantum starts
+static int arr_contended(run_t *run, int i) {
+    return run->slice - run->slice_used <= 1 && rr_contended(run, i);
+}
+
+
+// Get end of current slice when others wait for it, else LLONG_MAX
+static long long arr_next_event(run_t *run) {
+    int i = run->current;
+    if (i == -1 || !rr_contended(run, i)) return LLONG_MAX;
+    return *run->time + (run->slice - run->slice_used) * run->opts->quantum;
+}
+
+
+// Count quanta used of the slice
+static void arr_on_quantum_end(run_t *run, int i, int quanta) {
+    run->slice_used += quanta;
+}
+
+
+// Pick afresh once the running process is done
+static void arr_on_finish(run_t *run, int i) {
+    run->current = -1;
+    run->slice_ready--;
+    rr_on_finish(run, i);
+}
+
+
+// Take processes given memory into ready heap by remaining time
+static void srtf_admit(run_t *run) {
+    int count = admit_waiting(run);
+    for (int k = 0; k < count; k++) {
+        int i = run->admitted[k];
+        push_heap(run->heap, i, run->remain_time[i], run->seq++);
+    }
+}
+
+
+// Switch only to a strictly shorter remaining time
+static int srtf_pick_next(run_t *run) {
+    int i = run->current;
+    if (i != -1 && better_than_top(run->heap, run->remain_time[i], 0)) {
+        push_heap(run->heap, i, run->remain_time[i], run->seq++);
+        i = -1;
+    }
+    if (i == -1) i = pop_heap(run->heap);
+    run->current = i;
+    return i;
+}
+
+
+// Take processes given memory into ready heap by priority
+static void prio_admit(run_t *run) {
+    int count = admit_waiting(run);
+    for (int k = 0; k < count; k++) {
+        int i = run->admitted[k];
+        push_heap(run->heap, i, get_process_priority(run->p[i]), 
+                  run->seq++);
+    }
+}
+
+
+// Switch only to a strictly higher priority
+static int prio_pick_next(run_t *run) {
+    int i = run->current;
+    if (i != -1 && better_than_top(run->heap, 
+                                   get_process_priority(run->p[i]), 0)) {
+        push_heap(run->heap, i, get_process_priority(run->p[i]), 
+                  run->seq++);
+        i = -1;
+    }
+    if (i == -1) i = pop_heap(run->heap);
+    run->current = i;
+    return i;
+}
+
+
+// Get highest non-empty feedback level, -1 when all empty
+static int top_level(run_t *run) {
+    for (int l = 0; l < run->opts->levels; l++) {
+        if (get_fifo_size(run->levels[l]) > 0) return l;
+    }
+    return -1;
+}
+
+
+// Take processes given memory into top level, boosting when due
+static void mlfq_admit(run_t *run) {
+
+    options_t *opts = run->opts;
+    int count = admit_waiting(run);
+    for (int k = 0; k < count; k++) {
+        int i = run->admitted[k];
+        run->level[i] = 0;
+        run->used[i] = 0;
+        push_fifo(run->levels[0], i);
+    }
+
+    // periodically lift everything back to top level
+    if (opts->boost > 0 && *run->time >= run->next_boost) {
+        for (int l = 1; l < opts->levels; l++) {
+            int i;
+            while ((i = pop_fifo(run->levels[l])) != -1) {
+                run->level[i] = 0;
+                run->used[i] = 0;
+                push_fifo(run->levels[0], i);
+            }
+        }
+        if (run->current != -1) {
+            run->level[run->current] = 0;
+            run->used[run->current] = 0;
+        }
+
+        // next boost falls after now, even after a jump over idle time
+        long long missed = (*run->time - run->next_boost) / opts->boost;
+        run->next_boost += (missed + 1) * opts->boost;
+    }
+}
+
+
+// Demote once allotment is used, switch when a higher level is ready
+static int mlfq_pick_next(run_t *run) {
+
+    options_t *opts = run->opts;
+    int i = run->current;
+    if (i != -1) {
+        int l = run->level[i];
+        int top = top_level(run);
+        if (run->used[i] >= opts->level_quanta[l]) {
+            if (l < opts->levels - 1) run->level[i]++;
+            run->used[i] = 0;
+            push_fifo(run->levels[run->level[i]], i);
+            i = -1;
+        } else if (top != -1 && top < l) {
+            push_fifo(run->levels[l], i);
+            i = -1;
+        }
+    }
+
+    if (i == -1) {
+        int l = top_level(run);
+        i = l == -1 ? -1 : pop_fifo(run->levels[l]);
+    }
+    run->current = i;
+    return i;
+}
+
+
+// Check for any other process in the feedback levels
+static int mlfq_contended(run_t *run, int i) {
+    return top_level(run) != -1;
+}
+
+
+// Get time of next boost, LLONG_MAX without boosting
+static long long mlfq_next_event(run_t *run) {
+    if (run->opts->boost <= 0) return LLONG_MAX;
+    return run->next_boost;
+}
+
+
+// Count quanta used at current level
+// a lone process is demoted between quanta as if picked each time
+static void mlfq_on_quantum_end(run_t *run, int i, int quanta) {
+
+    options_t *opts = run->opts;
+    run->used[i] += quanta;
+    while (run->level[i] < opts->levels - 1 && 
+           run->used[i] > opts->level_quanta[run->level[i]]) {
+        run->used[i] -= opts->level_quanta[run->level[i]];
+        run->level[i]++;
+    }
+
+    // bottom level starts over on every allotment
+    int allot = opts->level_quanta[run->level[i]];
+    if (run->used[i] > allot) run->used[i] = (run->used[i] - 1) % allot + 1;
+}
+
+
+// Give memory to process from start, queueing it to run
+// the head job goes ahead of those backfilled while it waited, so they
+// can not push back the start it was reserved
+static void easy_ready(run_t *run, int i, int start, int backfill) {
+    remove_waiting(run->queue, i);
+    run->mem_allocated[i] = 1;
+    if (run->memory != NULL) {
+        run->memstart[i] = start;
+        print_ready_msg(run->out, *run->time, get_process_name(run->p[i]), 
+                        start);
+        if (run->opts->mem_sample) {
+            print_mem_msg(run->out, *run->time, run->memory);
+        }
+    }
+    if (backfill) {
+        push_fifo(run->fifo, i);
+        run->backfilled++;
+        return;
+    }
+    int size = get_fifo_size(run->fifo);
+    int behind = run->backfilled < size ? run->backfilled : size;
+    insert_fifo(run->fifo, i, size - behind);
+    run->backfilled = 0;
+}
+
+
+// Admit waiting processes in arrival order, and when the earliest
+// does not fit, reserve memory for it at the earliest finish it fits
+// after, letting later ones in which fit now and keep it intact
+static void easy_admit(run_t *run) {
+
+    mem_table_t *memory = run->memory;
+    wait_queue_t *queue = run->queue;
+    admit_arrivals(queue, *run->time);
+
+    int head;
+    while ((head = first_waiting(queue)) != -1) {
+        int start = -1;
+        if (memory != NULL) {
+            sample_mem(memory, *run->time);
+            start = allocate_mem(memory, run->size[head]);
+            if (start == -1) break;
+        } else if (!can_hold(run, run->size[head])) {
+            break;
+        }
+        easy_ready(run, head, start, 0);
+    }
+    if (head == -1 || memory == NULL || get_min_waiting(queue) > 
+                      get_mem_largest_hole(memory)) {
+        return;
+    }
+
+    // memory comes back in run order, running process first
+    reset_arena(run->scratch);
+    int *starts = arena_alloc(run->scratch, run->slots * sizeof(int));
+    int *sizes = arena_alloc(run->scratch, run->slots * sizeof(int));
+    int count = 0;
+    if (run->current != -1) {
+        starts[count] = run->memstart[run->current];
+        sizes[count++] = run->size[run->current];
+    }
+    for (int k = 0; k < get_fifo_size(run->fifo); k++) {
+        int i = get_fifo_at(run->fifo, k);
+        starts[count] = run->memstart[i];
+        sizes[count++] = run->size[i];
+    }
+    int reserved = frees_to_fit(memory, count, starts, sizes, -1, 0, 
+                                run->size[head]);
+    if (reserved == -1) return;
+
+    // backfill only where head still fits by its reserved finish
+    int j = next_waiting(queue, head);
+    while (j != -1) {
+        int next = next_waiting(queue, j);
+        int start = find_best_fit(memory, run->size[j]);
+        if (start != -1) {
+            int frees = frees_to_fit(memory, count, starts, sizes, start, 
+                                     run->size[j], run->size[head]);
+            if (frees != -1 && frees <= reserved) {
+                sample_mem(memory, *run->time);
+                allocate_mem(memory, run->size[j]);
+                easy_ready(run, j, start, 1);
+            }
+        }
+        j = next;
+    }
+}
+
+
+// Keep running current process, else take the longest queued
+static int easy_pick_next(run_t *run) {
+    if (run->current == -1) run->current = pop_fifo(run->fifo);
+    return run->current;
+}
+
+
+// Running process is done, pick afresh next time
+static void clear_current(run_t *run, int i) {
+    run->current = -1;
+}
+
+
+// Set up heap of ready processes
+static void heap_init(run_t *run) {
+    run->heap = create_ready_heap(run->capacity, run->arena);
+}
+
+
+// Set up ring of processes given memory, first come first served
+static void fifo_init(run_t *run) {
+    run->fifo = create_ready_fifo(run->capacity, run->arena);
+}
+
+
+// Set up counts of quanta arrivals need, up to the longest slice
+static void arr_init(run_t *run) {
+    run->service_quanta = arena_calloc(run->arena, run->opts->slice_max + 1, 
+                                       sizeof(int));
+}
+
+
+// Set up one ring per feedback level
+static void mlfq_init(run_t *run) {
+    options_t *opts = run->opts;
+    run->levels = arena_alloc(run->arena, opts->levels * 
+                              sizeof(ready_fifo_t *));
+    for (int l = 0; l < opts->levels; l++) {
+        run->levels[l] = create_ready_fifo(run->capacity, run->arena);
+    }
+    run->level = arena_calloc(run->arena, run->capacity, sizeof(int));
+    run->used = arena_calloc(run->arena, run->capacity, sizeof(int));
+    run->next_boost = opts->boost;
+}
+
+
+// Loops of each policy, with its hooks built in
+DEFINE_ENGINES(sjf, heap_init, sjf_admit, sjf_pick_next, never_contended, 
+               no_event, no_quantum_end, sjf_on_finish)
+DEFINE_ENGINES(rr, no_hook, rr_admit, rr_pick_next, rr_contended, 
+               no_event, no_quantum_end, rr_on_finish)
+DEFINE_ENGINES(srtf, heap_init, srtf_admit, srtf_pick_next, 
+               never_contended, no_event, no_quantum_end, clear_current)
+DEFINE_ENGINES(prio, heap_init, prio_admit, prio_pick_next, 
+               never_contended, no_event, no_quantum_end, clear_current)
+DEFINE_ENGINES(mlfq, mlfq_init, mlfq_admit, mlfq_pick_next, 
+               mlfq_contended, mlfq_next_event, mlfq_on_quantum_end, 
+               clear_current)
+DEFINE_ENGINES(easy, fifo_init, easy_admit, easy_pick_next, 
+               never_contended, no_event, no_quantum_end, clear_current)
+DEFINE_ENGINES(arr, arr_init, arr_admit, arr_pick_next, arr_contended, 
+               arr_next_event, arr_on_quantum_end, arr_on_finish)
+
+
+// SJF, SRTF and PRIO only change their pick on arrivals and finishes
+static sched_ops_t policies[] = {
+    {"SJF", compare_service_time, heap_init, sjf_admit, sjf_pick_next, 
+     NULL, NULL, NULL, sjf_on_finish, sjf_real, sjf_simulated},
+    {"RR", NULL, NULL, rr_admit, rr_pick_next, rr_contended, NULL, NULL, 
+     rr_on_finish, rr_real, rr_simulated},
+    {"SRTF", NULL, heap_init, srtf_admit, srtf_pick_next, NULL, NULL, 
+     NULL, clear_current, srtf_real, srtf_simulated},
+    {"PRIO", NULL, heap_init, prio_admit, prio_pick_next, NULL, NULL, 
+     NULL, clear_current, prio_real, prio_simulated},
+    {"MLFQ", NULL, mlfq_init, mlfq_admit, mlfq_pick_next, mlfq_contended, 
+     mlfq_next_event, mlfq_on_quantum_end, clear_current, mlfq_real, 
+     mlfq_simulated},
+    {"EASY", NULL, fifo_init, easy_admit, easy_pick_next, NULL, NULL, NULL, 
+     clear_current, easy_real, easy_simulated},
+    {"ARR", NULL, arr_init, arr_admit, arr_pick_next, arr_contended, 
+     arr_next_event, arr_on_quantum_end, arr_on_finish, arr_real, 
+     arr_simulated},
+};
+
+
+// Find scheduler ops by name, NULL when unknown
+sched_ops_t *find_policy(char *name) {
+    for (int i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (strcmp(policies[i].name, name) == 0) return &policies[i];
+    }
+    return NULL;
+}
\ No newline at end of file
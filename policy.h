@@ -0,0 +1,16 @@
+#ifndef _POLICY_H_
+#define _POLICY_H_
+
+#include "schedule.h"
+#include "engine.h"
+
+// adaptive round robin covers this percent of recent arrivals in one
+// slice, forgetting by halves every window of arrivals, and keeps
+// a round of the ready processes within this many longest slices
+#define SLICE_PERCENTILE 80
+#define SLICE_WINDOW 256
+#define SLICE_ROUND 4
+
+sched_ops_t *find_policy(char *name);
+
+#endif
\ No newline at end of file
@@ -11,6 +11,7 @@
 #define _POSIX_C_SOURCE 1
 
 #include <err.h>
+#include <errno.h>
 #include <getopt.h>
 #include <signal.h>
 #include <stdio.h>
@@ -21,21 +22,38 @@
 #include <sys/signalfd.h>
 #include <unistd.h>
 
+#include "ring.h"
+#include "sha256.h"
+#include "wire.h"
+
 static long pid = 0;
 static int verbose_flag = 0;
+/* Fast mode skips leftover checks and syncs unless verbose */
+static int fast_flag = 0;
+/* Spin mode busy waits for signals so the process burns its quantum */
+static int spin_flag = 0;
 typedef enum { STOP = 1, CONTINUE = 2, TERM = 3, START = 0 } Op;
 
+void read_full(uint8_t* buf, size_t len);
+size_t read_time(uint8_t* buf, uint64_t* time);
+void store_time(Op op, uint64_t time, uint8_t hash_content[128],
+				size_t* dest_index);
 void read_store_dword(Op op, uint8_t hash_content[128], size_t* dest_index);
+void read_store_span(uint8_t hash_content[128], size_t* dest_index);
 void store_process_name(const char* process_name, uint8_t hash_content[128],
 						size_t* dest_index);
-void sha256_hash(char hash_hexstring[65], const uint8_t* buf,
-				 const uint64_t nbyte);
+void check_leftover(void);
+void write_ack(uint8_t byte);
+void run_ring(ring_t* ring, uint8_t hash_content[128], size_t* dest_index);
 
 int main(int argc, char* argv[]) {
 	int c;
 	char* process_name;
 	static struct option long_options[] = {
 		{"verbose", no_argument, &verbose_flag, 1},
+		{"fast", no_argument, &fast_flag, 1},
+		{"spin", no_argument, &spin_flag, 1},
+		{"ring", required_argument, 0, 'r'},
 		{"help", no_argument, 0, 'h'},
 		{0, 0, 0, 0}};
 	int option_index;
@@ -48,10 +66,11 @@ int main(int argc, char* argv[]) {
 	size_t dest_index;
 	uint8_t sha_content[128];
 	char hash[65];
+	ring_t* ring = NULL;
 
 	while (1) {
 		option_index = 0;
-		c = getopt_long(argc, argv, "hv", long_options, &option_index);
+		c = getopt_long(argc, argv, "hvfr:", long_options, &option_index);
 		if (c == -1) {
 			break;
 		}
@@ -59,8 +78,16 @@ int main(int argc, char* argv[]) {
 		switch (c) {
 		case 0: break;
 		case 'v': verbose_flag = 1; break;
+		case 'f': fast_flag = 1; break;
+		case 'r':
+			/* Memory file shared with the scheduler, inherited across exec */
+			ring = map_ring(atoi(optarg));
+			close(atoi(optarg));
+			break;
 		case 'h':
-			printf("Usage: %s [-v|--verbose] <process-name>\n", argv[0]);
+			printf("Usage: %s [-v|--verbose] [-f|--fast] [--spin] "
+				   "[-r|--ring <fd>] <process-name>\n",
+				   argv[0]);
 			exit(EXIT_SUCCESS);
 		}
 	}
@@ -84,20 +111,27 @@ int main(int argc, char* argv[]) {
 	sigaddset(&mask, SIGTERM);
 	sigaddset(&mask, SIGTSTP);
 	sigaddset(&mask, SIGCONT);
+	sigaddset(&mask, SIGUSR1);
 	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
 		err(EXIT_FAILURE, "sigprocmask");
 	}
-	sfd = signalfd(-1, &mask, 0);
+	sfd = signalfd(-1, &mask, spin_flag ? SFD_NONBLOCK : 0);
 	if (sfd == -1) {
 		err(EXIT_FAILURE, "signalfd");
 	}
 
 	/* Synchronisation at the start */
 	/* Must be placed after signal setup to prevent race */
+	if (ring != NULL) {
+		run_ring(ring, sha_content, &dest_index);
+	}
 	read_store_dword(START, sha_content, &dest_index);
 
 	for (;;) {
 		s = read(sfd, &fdsi, sizeof(fdsi));
+		if (s == -1 && errno == EAGAIN) {
+			continue;
+		}
 		if (s != sizeof(fdsi)) {
 			err(EXIT_FAILURE, "read");
 		}
@@ -143,6 +177,12 @@ int main(int argc, char* argv[]) {
 				err(EXIT_FAILURE, "sigprocmask");
 			}
 			read_store_dword(CONTINUE, sha_content, &dest_index);
+		} else if (fdsi.ssi_signo == SIGUSR1) {
+			if (verbose_flag) {
+				fprintf(stderr, "[process.c (%ld)] handling SIGUSR1\n", pid);
+			}
+			/* Span of continues while already running */
+			read_store_span(sha_content, &dest_index);
 		} else {
 			fprintf(stderr, "Read unexpected signal\n");
 		}
@@ -169,12 +209,49 @@ void store_process_name(const char* process_name, uint8_t hash_content[128],
 		  dest_index);
 }
 
+/* Read exactly len bytes from stdin */
+void read_full(uint8_t* buf, size_t len) {
+	size_t got;
+	ssize_t n;
+
+	got = 0;
+	while (got < len) {
+		n = read(STDIN_FILENO, buf + got, len - got);
+		if (n < 0) {
+			err(EXIT_FAILURE, "read");
+		}
+		got += n;
+	}
+}
+
+/* Read a time as wire.h sends it, 4 bytes or the escape and 8 more */
+/* Returns number of bytes read into buf */
+size_t read_time(uint8_t* buf, uint64_t* time) {
+	read_full(buf, 4);
+	*time = get_wire(buf, 4);
+	if (*time != WIRE_ESCAPE) {
+		return 4;
+	}
+	read_full(buf + 4, 8);
+	*time = get_wire(buf + 4, 8);
+	return 12;
+}
+
+/* Store op and time as they would have been read */
+void store_time(Op op, uint64_t time, uint8_t hash_content[128],
+				size_t* dest_index) {
+	uint8_t buf[1 + WIRE_MAX_TIME];
+
+	buf[0] = op;
+	store(buf, 1 + put_time(buf + 1, time), hash_content, dest_index);
+}
+
 void read_store_dword(Op op, uint8_t hash_content[128], size_t* dest_index) {
-	uint8_t buf[5];
-	size_t len, n;
+	uint8_t buf[1 + WIRE_MAX_TIME];
+	uint64_t time;
+	size_t len;
 
 	buf[0] = op;
-	len = 1;
 	if (verbose_flag) {
 		fprintf(
 			stderr,
@@ -182,250 +259,134 @@ void read_store_dword(Op op, uint8_t hash_content[128], size_t* dest_index) {
 			pid);
 		fflush(stderr);
 	}
-	while (len < 5) {
-		n = read(STDIN_FILENO, buf + len, 5 - len);
-		if (n < 0) {
-			err(EXIT_FAILURE, "read");
-		}
-		len += n;
-	}
+	len = 1 + read_time(buf + 1, &time);
 
 	if (verbose_flag) {
 		fprintf(stderr,
-				"[process.c (%ld)] op %d, time %u, hex bytes [%02x, %02x, "
+				"[process.c (%ld)] op %d, time %llu, hex bytes [%02x, %02x, "
 				"%02x, %02x]\n",
-				pid, op,
-				((uint32_t)buf[1]) << 24 | ((uint32_t)buf[2]) << 16 |
-					((uint32_t)buf[3]) << 8 | (uint32_t)buf[4],
-				buf[1], buf[2], buf[3], buf[4]);
+				pid, op, (unsigned long long)time, buf[len - 4],
+				buf[len - 3], buf[len - 2], buf[len - 1]);
+	}
+	check_leftover();
+
+	/* Need to prevent race condition between SIGCONT and SIGTERM */
+	if (op == CONTINUE || op == START) {
+		write_ack(buf[len - 1]);
+	}
+
+	store(buf, len, hash_content, dest_index);
+}
+
+void check_leftover(void) {
+	int n;
+
+	/* Debug only in fast mode, the scheduler never sends extra bytes */
+	if (fast_flag && !verbose_flag) {
+		return;
 	}
 	if (ioctl(STDIN_FILENO, FIONREAD, &n) == 0 && n > 0) {
 		fprintf(stderr, "[process.c (%ld)] Error: Leftover bytes in stdin\n",
 				pid);
 		exit(EXIT_FAILURE);
 	}
+}
 
-	/* Need to prevent race condition between SIGCONT and SIGTERM */
-	if (op == CONTINUE || op == START) {
-		while (1) {
-			n = write(STDOUT_FILENO, &buf[4], 1);
-			if (n < 0) {
-				err(EXIT_FAILURE, "write");
-			}
-			if (n == 1) {
-				break;
-			}
-		}
-		fsync(STDOUT_FILENO);
-		fflush(stdout);
+void write_ack(uint8_t byte) {
+	ssize_t n;
 
-		if (verbose_flag) {
-			fprintf(stderr,
-					"[process.c (%ld)] wrote hex byte [%02x] to stdout\n", pid,
-					buf[4]);
-			fflush(stderr);
+	while (1) {
+		n = write(STDOUT_FILENO, &byte, 1);
+		if (n < 0) {
+			err(EXIT_FAILURE, "write");
+		}
+		if (n == 1) {
+			break;
 		}
 	}
 
-	store(buf, 5, hash_content, dest_index);
-}
-
-/*****************************************************************************/
-/* SHA-256 Hashing, implemented by Steven Tang */
-/* Reference: RFC 6234 */
-
-/* SHA-256 Functions: RFC 6234, FIPS 180-3 section 4.1.2 */
-#define SHA_Ch(x, y, z) (((x) & (y)) ^ ((~(x)) & (z)))
-#define SHA_Maj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
-
-#define SHA256_SHR(bits, word) ((word) >> (bits))
-#define SHA256_ROTL(bits, word)                                               \
-	(((word) << (bits)) | ((word) >> (32 - (bits))))
-#define SHA256_ROTR(bits, word)                                               \
-	(((word) >> (bits)) | ((word) << (32 - (bits))))
-
-#define SHA256_BSIG0(word)                                                    \
-	(SHA256_ROTR(2, word) ^ SHA256_ROTR(13, word) ^ SHA256_ROTR(22, word))
-#define SHA256_BSIG1(word)                                                    \
-	(SHA256_ROTR(6, word) ^ SHA256_ROTR(11, word) ^ SHA256_ROTR(25, word))
-#define SHA256_SSIG0(word)                                                    \
-	(SHA256_ROTR(7, word) ^ SHA256_ROTR(18, word) ^ SHA256_SHR(3, word))
-#define SHA256_SSIG1(word)                                                    \
-	(SHA256_ROTR(17, word) ^ SHA256_ROTR(19, word) ^ SHA256_SHR(10, word))
-
-/* SHA-256 Initial Hash Values: FIPS 180-3 section 5.3.3 */
-static uint32_t SHA256_H0[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372,
-								0xA54FF53A, 0x510E527F, 0x9B05688C,
-								0x1F83D9AB, 0x5BE0CD19};
-
-/* SHA-256 Constants: FIPS 180-3, section 4.2.2 */
-static const uint32_t K[64] = {
-	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
-	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
-	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
-	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
-	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
-
-void sha256_init(uint32_t hash[8]);
-void sha256_process(uint32_t message_block[16], uint32_t hash[8]);
-void sha256_process_final(uint64_t nbyte, short leftover_bytes,
-						  uint32_t last_block[16], uint32_t hash[8]);
-void uint32_array_to_hex_string(char* out, uint32_t* in, unsigned long length);
-#ifdef DEBUG
-void print_uint32_array(uint32_t* arr, unsigned long length);
-#endif
-
-void sha256_hash(char hash_hexstring[65], const uint8_t* buf,
-				 const uint64_t nbyte) {
-	uint64_t i, num_blocks;
-	uint32_t hash[8], last_block[16];
-	short leftover_bytes;
-
-	/* each block is 512 bits, or 64 bytes */
-	/* last block needs to be processed differently for padding */
-	leftover_bytes = nbyte % 64;
-	num_blocks = leftover_bytes == 0 ? nbyte / 64 : nbyte / 64 + 1;
-
-#ifdef DEBUG
-	fprintf(stderr, "Blocks: %ld, Leftover bytes %d\n", num_blocks,
-			leftover_bytes);
-#endif
-
-	/* init */
-	sha256_init(hash);
-
-	/* process */
-	/* 64 = 512 bits per block / 8 bits for uint8_t */
-	for (i = 0; i < (leftover_bytes == 0 ? num_blocks : num_blocks - 1); i++) {
-		sha256_process((uint32_t*)(buf + i * 64), hash);
+	/* Nothing is buffered on a pipe written with write */
+	if (!fast_flag) {
+		fsync(STDOUT_FILENO);
+		fflush(stdout);
 	}
 
-	/* final block */
-	memset(last_block, 0, 64);
-	if (leftover_bytes != 0) {
-		memcpy(last_block, buf + i * 64, leftover_bytes);
+	if (verbose_flag) {
+		fprintf(stderr, "[process.c (%ld)] wrote hex byte [%02x] to stdout\n",
+				pid, byte);
+		fflush(stderr);
 	}
-	sha256_process_final(nbyte, leftover_bytes, last_block, hash);
-
-	/* print to buffer as hex string */
-	uint32_array_to_hex_string(hash_hexstring, hash, 8);
 }
 
-/* SHA-256 Initialization */
-/* https://www.rfc-editor.org/rfc/rfc6234#section-6.1 */
-void sha256_init(uint32_t hash[8]) {
-	int i;
-	for (i = 0; i < 8; i++) {
-		hash[i] = SHA256_H0[i];
-	}
-}
+/* Read first time, step and count, storing one CONTINUE per time */
+void read_store_span(uint8_t hash_content[128], size_t* dest_index) {
+	uint8_t in[WIRE_MAX_TIME + 8];
+	uint64_t from, time;
+	uint32_t step, count, i;
+	size_t len;
 
-/* SHA-256 Processing */
-/* For each 32 * 16 = 512 block of bytes */
-/* https://www.rfc-editor.org/rfc/rfc6234#section-6.2 */
-void sha256_process(uint32_t message_block[16], uint32_t hash[8]) {
-	int t;
-	uint32_t a, b, c, d, e, f, g, h, t1, t2;
-	uint32_t w[64];
-	uint8_t* message_ptr;
-
-	/* prepare message schedule */
-	for (t = 0; t < 64; t++) {
-		if (t < 16) {
-			message_ptr = (uint8_t*)&message_block[t];
-			w[t] = message_ptr[0] << 24 | message_ptr[1] << 16 |
-				   message_ptr[2] << 8 | message_ptr[3];
-		} else {
-			w[t] = SHA256_SSIG1(w[t - 2]) + w[t - 7] +
-				   SHA256_SSIG0(w[t - 15]) + w[t - 16];
-		}
+	len = read_time(in, &from);
+	read_full(in + len, 8);
+	step = get_wire(in + len, 4);
+	count = get_wire(in + len + 4, 4);
+
+	if (verbose_flag) {
+		fprintf(stderr,
+				"[process.c (%ld)] span from %llu, step %u, count %u\n", pid,
+				(unsigned long long)from, step, count);
+	}
+	check_leftover();
+	if (count == 0) {
+		fprintf(stderr, "[process.c (%ld)] Error: Empty span\n", pid);
+		exit(EXIT_FAILURE);
 	}
 
-	/* initialize working variables */
-	a = hash[0];
-	b = hash[1];
-	c = hash[2];
-	d = hash[3];
-	e = hash[4];
-	f = hash[5];
-	g = hash[6];
-	h = hash[7];
-
-	/* main hash computation */
-	for (t = 0; t < 64; t++) {
-		t1 = h + SHA256_BSIG1(e) + SHA_Ch(e, f, g) + K[t] + w[t];
-		t2 = SHA256_BSIG0(a) + SHA_Maj(a, b, c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
+	time = from;
+	for (i = 0; i < count; i++) {
+		time = from + (uint64_t)i * step;
+		store_time(CONTINUE, time, hash_content, dest_index);
 	}
 
-	/* calculate intermediate hash value H(i) */
-	hash[0] += a;
-	hash[1] += b;
-	hash[2] += c;
-	hash[3] += d;
-	hash[4] += e;
-	hash[5] += f;
-	hash[6] += g;
-	hash[7] += h;
+	write_ack(time);
 }
 
-/* SHA-256 processing for final block */
-/* Padding - "1" followed by m "0"s followed by 64-bit integer */
-/* https://www.rfc-editor.org/rfc/rfc6234#section-4.1 */
-void sha256_process_final(uint64_t nbyte, short leftover_bytes,
-						  uint32_t last_block[16], uint32_t hash[8]) {
-	/* Append "1" bit */
-	((uint8_t*)last_block)[leftover_bytes] = 1 << 7;
-
-	/* Length will be in next block since it doesn't fit */
-	if (leftover_bytes > 64 - 8 - 1) {
-		sha256_process(last_block, hash);
-		memset(last_block, 0, 64);
-	}
+/* Take (op, time) records from the shared ring instead of stdin */
+/* STOP stops this process itself, TERM leaves the hash in the ring */
+void run_ring(ring_t* ring, uint8_t hash_content[128], size_t* dest_index) {
+	ring_record_t record;
+	uint64_t time;
+	uint32_t i;
+	char hash[65];
 
-	/* Set length, process last block */
-	((uint8_t*)last_block)[56] = (nbyte * 8 >> (64 - 8)) & 0xFF;
-	((uint8_t*)last_block)[57] = (nbyte * 8 >> (64 - 16)) & 0xFF;
-	((uint8_t*)last_block)[58] = (nbyte * 8 >> (64 - 24)) & 0xFF;
-	((uint8_t*)last_block)[59] = (nbyte * 8 >> (64 - 32)) & 0xFF;
-	((uint8_t*)last_block)[60] = (nbyte * 8 >> (64 - 40)) & 0xFF;
-	((uint8_t*)last_block)[61] = (nbyte * 8 >> (64 - 48)) & 0xFF;
-	((uint8_t*)last_block)[62] = (nbyte * 8 >> (64 - 56)) & 0xFF;
-	((uint8_t*)last_block)[63] = (nbyte * 8 >> (64 - 64)) & 0xFF;
-
-	sha256_process(last_block, hash);
-}
+	for (;;) {
+		pop_ring(ring, &record);
+		if (verbose_flag) {
+			fprintf(stderr,
+					"[process.c (%ld)] ring op %u, from %llu, step %u, "
+					"count %u\n",
+					pid, record.op, (unsigned long long)record.from,
+					record.step, record.count);
+		}
+		if (record.count == 0 || record.op > TERM) {
+			fprintf(stderr, "[process.c (%ld)] Error: Bad ring record\n",
+					pid);
+			exit(EXIT_FAILURE);
+		}
 
-#ifdef DEBUG
-/* Prints a uint32 array */
-void print_uint32_array(uint32_t* arr, unsigned long length) {
-	unsigned long i;
-	for (i = 0; i < length; i++) {
-		fprintf(stderr, "%08x", arr[i]);
-	}
-	fprintf(stderr, "\n");
-}
-#endif
-
-/* Returns a uint32 array in hex notation */
-void uint32_array_to_hex_string(char* out, uint32_t* in,
-								unsigned long length) {
-	int i;
-	for (i = 0; i < length; i++) {
-		sprintf(out + (i * 8), "%08x", in[i]);
+		time = record.from;
+		for (i = 0; i < record.count; i++) {
+			time = record.from + (uint64_t)i * record.step;
+			store_time(record.op, time, hash_content, dest_index);
+		}
+
+		if (record.op == TERM) {
+			sha256_hash(hash, hash_content, 128 - 9);
+			ack_ring(ring, time, hash);
+			exit(EXIT_SUCCESS);
+		}
+		ack_ring(ring, time, NULL);
+		if (record.op == STOP) {
+			raise(SIGSTOP);
+		}
 	}
-	out[64] = 0;
 }
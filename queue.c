@@ -0,0 +1,348 @@
+#include "queue.h"
+
+#define NOT_ARRIVED 0
+#define WAITING 1
+#define DONE 2
+
+struct wait_queue
+{
+    int n;
+    int capacity;
+    long long *arrival;
+    int *size;
+
+    // arrival order and how far it has been fed into the queue
+    // a ring once more processes have come than there is room for
+    int *order;
+    int fed;
+
+    // waiting processes in arrival order as a linked list
+    int *state;
+    int *prev;
+    int *next;
+    int head;
+    int tail;
+    int count;
+
+    // min heap of waiting processes by memory size
+    int *heap;
+    int *pos;
+
+    // place of each in arrival order, to pick among heap entries
+    int *rank;
+};
+
+
+// Sort process indices by arrival, keeping input order on ties
+static void sort_by_arrival(int *order, int n, long long *arrival, 
+                            arena_t *arena) {
+
+    // most traces already come in arrival order
+    int sorted = 1;
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+        if (i > 0 && arrival[i] < arrival[i - 1]) sorted = 0;
+    }
+    if (sorted) return;
+
+    // stable bottom up merge sort
+    int *temp = arena_alloc(arena, n * sizeof(int));
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int a = lo, b = mid, k = lo;
+            while (a < mid && b < hi) {
+                if (arrival[order[b]] < arrival[order[a]]) {
+                    temp[k++] = order[b++];
+                } else {
+                    temp[k++] = order[a++];
+                }
+            }
+            while (a < mid) temp[k++] = order[a++];
+            while (b < hi) temp[k++] = order[b++];
+        }
+        memcpy(order, temp, n * sizeof(int));
+    }
+}
+
+
+// Check whether heap slot a should sit above slot b
+static int heap_less(wait_queue_t *queue, int a, int b) {
+    int x = queue->heap[a];
+    int y = queue->heap[b];
+    if (queue->size[x] != queue->size[y]) {
+        return queue->size[x] < queue->size[y];
+    }
+    return x < y;
+}
+
+
+// Swap two heap slots, keeping positions in step
+static void heap_swap(wait_queue_t *queue, int a, int b) {
+    int temp = queue->heap[a];
+    queue->heap[a] = queue->heap[b];
+    queue->heap[b] = temp;
+    queue->pos[queue->heap[a]] = a;
+    queue->pos[queue->heap[b]] = b;
+}
+
+
+// Restore heap order around slot
+static void heap_fix(wait_queue_t *queue, int slot) {
+
+    // move up while smaller than parent
+    while (slot > 0 && heap_less(queue, slot, (slot - 1) / 2)) {
+        heap_swap(queue, slot, (slot - 1) / 2);
+        slot = (slot - 1) / 2;
+    }
+
+    // move down while larger than a child
+    while (1) {
+        int smallest = slot;
+        int left = 2 * slot + 1;
+        int right = 2 * slot + 2;
+        if (left < queue->count && heap_less(queue, left, smallest)) {
+            smallest = left;
+        }
+        if (right < queue->count && heap_less(queue, right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == slot) break;
+        heap_swap(queue, slot, smallest);
+        slot = smallest;
+    }
+}
+
+
+// Create empty queue with room for capacity processes
+// which are added in arrival order as they come
+wait_queue_t *create_open_queue(int capacity, long long *arrival, 
+                                int *size, arena_t *arena) {
+    wait_queue_t *queue = arena_alloc(arena, sizeof(wait_queue_t));
+    queue->n = 0;
+    queue->capacity = capacity;
+    queue->arrival = arrival;
+    queue->size = size;
+    queue->order = arena_alloc(arena, capacity * sizeof(int));
+    queue->state = arena_calloc(arena, capacity, sizeof(int));
+    queue->prev = arena_alloc(arena, capacity * sizeof(int));
+    queue->next = arena_alloc(arena, capacity * sizeof(int));
+    queue->heap = arena_alloc(arena, capacity * sizeof(int));
+    queue->pos = arena_alloc(arena, capacity * sizeof(int));
+    queue->rank = arena_alloc(arena, capacity * sizeof(int));
+    queue->fed = 0;
+    queue->head = -1;
+    queue->tail = -1;
+    queue->count = 0;
+    return queue;
+}
+
+
+// Create queue of processes waiting on memory
+wait_queue_t *create_wait_queue(int n, long long *arrival, int *size, 
+                                arena_t *arena) {
+    wait_queue_t *queue = create_open_queue(n, arrival, size, arena);
+    queue->n = n;
+    sort_by_arrival(queue->order, n, arrival, arena);
+    return queue;
+}
+
+
+// Add process arriving no earlier than any added before
+// its slot may have been left by one that finished
+void add_arrival(wait_queue_t *queue, int index) {
+    queue->state[index] = NOT_ARRIVED;
+    queue->order[queue->n++ % queue->capacity] = index;
+}
+
+
+// Move processes arrived by given time to the back of the queue
+int admit_arrivals(wait_queue_t *queue, long long time) {
+
+    int admitted = 0;
+    while (queue->fed < queue->n &&
+           queue->arrival[queue->order[queue->fed % queue->capacity]] <= 
+           time) {
+        int rank = queue->fed;
+        int i = queue->order[queue->fed++ % queue->capacity];
+        if (queue->state[i] != NOT_ARRIVED) continue;
+        queue->rank[i] = rank;
+
+        // append to arrival list
+        queue->state[i] = WAITING;
+        queue->prev[i] = queue->tail;
+        queue->next[i] = -1;
+        if (queue->tail != -1) {
+            queue->next[queue->tail] = i;
+        } else {
+            queue->head = i;
+        }
+        queue->tail = i;
+
+        // index by size
+        queue->heap[queue->count] = i;
+        queue->pos[i] = queue->count;
+        queue->count++;
+        heap_fix(queue, queue->count - 1);
+
+        admitted++;
+    }
+
+    return admitted;
+}
+
+
+// Get earliest arrived waiting process
+int first_waiting(wait_queue_t *queue) {
+    return queue->head;
+}
+
+
+// Get waiting process arrived after given one
+int next_waiting(wait_queue_t *queue, int index) {
+    return queue->next[index];
+}
+
+
+// Get last arrived waiting process, -1 when none
+int last_waiting(wait_queue_t *queue) {
+    return queue->tail;
+}
+
+
+// Get waiting process arrived before given one
+int prev_waiting(wait_queue_t *queue, int index) {
+    return queue->prev[index];
+}
+
+
+// Check if process is waiting on memory
+int is_waiting(wait_queue_t *queue, int index) {
+    return queue->state[index] == WAITING;
+}
+
+
+// Take process out of queue, or keep it from joining later
+void remove_waiting(wait_queue_t *queue, int index) {
+
+    if (queue->state[index] != WAITING) {
+        queue->state[index] = DONE;
+        return;
+    }
+    queue->state[index] = DONE;
+
+    // unlink from arrival list
+    if (queue->prev[index] != -1) {
+        queue->next[queue->prev[index]] = queue->next[index];
+    } else {
+        queue->head = queue->next[index];
+    }
+    if (queue->next[index] != -1) {
+        queue->prev[queue->next[index]] = queue->prev[index];
+    } else {
+        queue->tail = queue->prev[index];
+    }
+
+    // replace with last heap slot
+    int slot = queue->pos[index];
+    queue->count--;
+    if (slot != queue->count) {
+        heap_swap(queue, slot, queue->count);
+        heap_fix(queue, slot);
+    }
+}
+
+
+// Get smallest memory size still waiting
+int get_min_waiting(wait_queue_t *queue) {
+    if (queue->count == 0) return INT_MAX;
+    return queue->size[queue->heap[0]];
+}
+
+
+// Get earliest arrived of those below slot in heap of size at most
+// hole, never entering a subtree whose top is larger, -1 when none
+static int earliest_fitting(wait_queue_t *queue, int slot, int hole) {
+    if (slot >= queue->count || queue->size[queue->heap[slot]] > hole) {
+        return -1;
+    }
+    int best = queue->heap[slot];
+    for (int child = 2 * slot + 1; child <= 2 * slot + 2; child++) {
+        int i = earliest_fitting(queue, child, hole);
+        if (i != -1 && queue->rank[i] < queue->rank[best]) best = i;
+    }
+    return best;
+}
+
+
+// Get earliest arrived waiting process of size at most hole, -1 when
+// none, only those which fit are visited
+int first_fitting(wait_queue_t *queue, int hole) {
+    return earliest_fitting(queue, 0, hole);
+}
+
+
+// Get arrival time of next process not yet queued
+long long get_next_arrival(wait_queue_t *queue) {
+    while (queue->fed < queue->n && 
+           queue->state[queue->order[queue->fed % queue->capacity]] != 
+           NOT_ARRIVED) {
+        queue->fed++;
+    }
+    if (queue->fed == queue->n) return LLONG_MAX;
+    return queue->arrival[queue->order[queue->fed % queue->capacity]];
+}
+
+
+// Get process indices in arrival order, input order on ties
+int *get_arrival_order(wait_queue_t *queue) {
+    return queue->order;
+}
+
+
+// Get number of processes waiting
+int get_num_waiting(wait_queue_t *queue) {
+    return queue->count;
+}
+
+
+// Write queue state, the arrival order is rebuilt from the trace
+void save_wait_queue(wait_queue_t *queue, FILE *file) {
+    int n = queue->n;
+    fwrite(&queue->fed, sizeof(int), 1, file);
+    fwrite(&queue->head, sizeof(int), 1, file);
+    fwrite(&queue->tail, sizeof(int), 1, file);
+    fwrite(&queue->count, sizeof(int), 1, file);
+    fwrite(queue->state, sizeof(int), n, file);
+    fwrite(queue->prev, sizeof(int), n, file);
+    fwrite(queue->next, sizeof(int), n, file);
+    fwrite(queue->heap, sizeof(int), queue->count, file);
+    fwrite(queue->pos, sizeof(int), n, file);
+}
+
+
+// Read queue state written by save_wait_queue
+// return 0 when it does not match the queue's size
+int load_wait_queue(wait_queue_t *queue, FILE *file) {
+    int n = queue->n;
+    fread(&queue->fed, sizeof(int), 1, file);
+    fread(&queue->head, sizeof(int), 1, file);
+    fread(&queue->tail, sizeof(int), 1, file);
+    fread(&queue->count, sizeof(int), 1, file);
+    if (queue->fed < 0 || queue->fed > n || 
+        queue->count < 0 || queue->count > n) {
+        return 0;
+    }
+    fread(queue->state, sizeof(int), n, file);
+    fread(queue->prev, sizeof(int), n, file);
+    fread(queue->next, sizeof(int), n, file);
+    fread(queue->heap, sizeof(int), queue->count, file);
+    fread(queue->pos, sizeof(int), n, file);
+
+    // arrival order is that of the trace
+    for (int k = 0; k < n; k++) {
+        queue->rank[queue->order[k]] = k;
+    }
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef _QUEUE_H_
+#define _QUEUE_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdio.h>
+
+#include "arena.h"
+
+typedef struct wait_queue wait_queue_t;
+
+wait_queue_t *create_open_queue(int capacity, long long *arrival, 
+                                int *size, arena_t *arena);
+
+wait_queue_t *create_wait_queue(int n, long long *arrival, int *size, 
+                                arena_t *arena);
+
+void add_arrival(wait_queue_t *queue, int index);
+
+int admit_arrivals(wait_queue_t *queue, long long time);
+
+int first_waiting(wait_queue_t *queue);
+
+int next_waiting(wait_queue_t *queue, int index);
+
+int last_waiting(wait_queue_t *queue);
+
+int prev_waiting(wait_queue_t *queue, int index);
+
+int is_waiting(wait_queue_t *queue, int index);
+
+void remove_waiting(wait_queue_t *queue, int index);
+
+int get_min_waiting(wait_queue_t *queue);
+
+int first_fitting(wait_queue_t *queue, int hole);
+
+long long get_next_arrival(wait_queue_t *queue);
+
+int get_num_waiting(wait_queue_t *queue);
+
+int *get_arrival_order(wait_queue_t *queue);
+
+void save_wait_queue(wait_queue_t *queue, FILE *file);
+
+int load_wait_queue(wait_queue_t *queue, FILE *file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "ready.h"
+
+typedef struct entry
+{
+    long long key;
+    uint32_t tie;
+    int index;
+} entry_t;
+
+struct ready_heap
+{
+    entry_t *entries;
+    int capacity;
+    int count;
+};
+
+struct ready_fifo
+{
+    int *ring;
+    int capacity;
+    int head;
+    int count;
+};
+
+
+// Check entry a comes before b, by key then tie breaker
+static int is_before(entry_t *a, entry_t *b) {
+    return a->key < b->key || (a->key == b->key && a->tie < b->tie);
+}
+
+
+// Create min heap of ready processes, O(log n) push and pop
+ready_heap_t *create_ready_heap(int n, arena_t *arena) {
+    ready_heap_t *heap = arena_alloc(arena, sizeof(ready_heap_t));
+    heap->entries = arena_alloc(arena, n * sizeof(entry_t));
+    heap->capacity = n;
+    heap->count = 0;
+    return heap;
+}
+
+
+// Add process ordered by key, then tie breaker
+void push_heap(ready_heap_t *heap, int index, long long key, int tie) {
+
+    entry_t entry = {key, tie, index};
+    int slot = heap->count++;
+
+    // move up while smaller than parent
+    while (slot > 0 && is_before(&entry, &heap->entries[(slot - 1) / 2])) {
+        heap->entries[slot] = heap->entries[(slot - 1) / 2];
+        slot = (slot - 1) / 2;
+    }
+    heap->entries[slot] = entry;
+}
+
+
+// Get process with smallest key, -1 when empty
+int peek_heap(ready_heap_t *heap) {
+    if (heap->count == 0) return -1;
+    return heap->entries[0].index;
+}
+
+
+// Take process with smallest key, -1 when empty
+int pop_heap(ready_heap_t *heap) {
+
+    if (heap->count == 0) return -1;
+    int top = heap->entries[0].index;
+    entry_t last = heap->entries[--heap->count];
+
+    // move last entry down from root
+    int slot = 0;
+    while (1) {
+        int child = 2 * slot + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && 
+            is_before(&heap->entries[child + 1], &heap->entries[child])) {
+            child++;
+        }
+        if (!is_before(&heap->entries[child], &last)) break;
+        heap->entries[slot] = heap->entries[child];
+        slot = child;
+    }
+    if (heap->count > 0) heap->entries[slot] = last;
+
+    return top;
+}
+
+
+// Check if smallest key in heap is strictly below given key
+int better_than_top(ready_heap_t *heap, long long key, int tie) {
+    entry_t entry = {key, tie, -1};
+    return heap->count > 0 && is_before(&heap->entries[0], &entry);
+}
+
+
+// Get number of processes in heap
+int get_heap_size(ready_heap_t *heap) {
+    return heap->count;
+}
+
+
+// Create first in first out ring of ready processes, O(1) each way
+ready_fifo_t *create_ready_fifo(int n, arena_t *arena) {
+    ready_fifo_t *fifo = arena_alloc(arena, sizeof(ready_fifo_t));
+    fifo->ring = arena_alloc(arena, n * sizeof(int));
+    fifo->capacity = n;
+    fifo->head = 0;
+    fifo->count = 0;
+    return fifo;
+}
+
+
+// Add process at back of ring
+void push_fifo(ready_fifo_t *fifo, int index) {
+    fifo->ring[(fifo->head + fifo->count) % fifo->capacity] = index;
+    fifo->count++;
+}
+
+
+// Take process from front of ring, -1 when empty
+int pop_fifo(ready_fifo_t *fifo) {
+    if (fifo->count == 0) return -1;
+    int index = fifo->ring[fifo->head];
+    fifo->head = (fifo->head + 1) % fifo->capacity;
+    fifo->count--;
+    return index;
+}
+
+
+// Add process k places from the front of ring, moving those from
+// there on back by one
+void insert_fifo(ready_fifo_t *fifo, int index, int k) {
+    for (int m = fifo->count; m > k; m--) {
+        fifo->ring[(fifo->head + m) % fifo->capacity] = 
+            fifo->ring[(fifo->head + m - 1) % fifo->capacity];
+    }
+    fifo->ring[(fifo->head + k) % fifo->capacity] = index;
+    fifo->count++;
+}
+
+
+// Get number of processes in ring
+int get_fifo_size(ready_fifo_t *fifo) {
+    return fifo->count;
+}
+
+
+// Get process k places from the front of ring
+int get_fifo_at(ready_fifo_t *fifo, int k) {
+    return fifo->ring[(fifo->head + k) % fifo->capacity];
+}
+
+
+// Write heap entries as they lie
+void save_ready_heap(ready_heap_t *heap, FILE *file) {
+    fwrite(&heap->count, sizeof(int), 1, file);
+    fwrite(heap->entries, sizeof(entry_t), heap->count, file);
+}
+
+
+// Read heap written by save_ready_heap, 0 when it does not fit
+int load_ready_heap(ready_heap_t *heap, FILE *file) {
+    fread(&heap->count, sizeof(int), 1, file);
+    if (heap->count < 0 || heap->count > heap->capacity) return 0;
+    fread(heap->entries, sizeof(entry_t), heap->count, file);
+    return 1;
+}
+
+
+// Write ring contents front to back
+void save_ready_fifo(ready_fifo_t *fifo, FILE *file) {
+    fwrite(&fifo->count, sizeof(int), 1, file);
+    for (int k = 0; k < fifo->count; k++) {
+        fwrite(&fifo->ring[(fifo->head + k) % fifo->capacity], 
+               sizeof(int), 1, file);
+    }
+}
+
+
+// Read ring written by save_ready_fifo, 0 when it does not fit
+int load_ready_fifo(ready_fifo_t *fifo, FILE *file) {
+    fifo->head = 0;
+    fread(&fifo->count, sizeof(int), 1, file);
+    if (fifo->count < 0 || fifo->count > fifo->capacity) return 0;
+    fread(fifo->ring, sizeof(int), fifo->count, file);
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef _READY_H_
+#define _READY_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+
+typedef struct ready_heap ready_heap_t;
+typedef struct ready_fifo ready_fifo_t;
+
+ready_heap_t *create_ready_heap(int n, arena_t *arena);
+
+void push_heap(ready_heap_t *heap, int index, long long key, int tie);
+
+int peek_heap(ready_heap_t *heap);
+
+int pop_heap(ready_heap_t *heap);
+
+int better_than_top(ready_heap_t *heap, long long key, int tie);
+
+int get_heap_size(ready_heap_t *heap);
+
+ready_fifo_t *create_ready_fifo(int n, arena_t *arena);
+
+void push_fifo(ready_fifo_t *fifo, int index);
+
+int pop_fifo(ready_fifo_t *fifo);
+
+void insert_fifo(ready_fifo_t *fifo, int index, int k);
+
+int get_fifo_size(ready_fifo_t *fifo);
+
+int get_fifo_at(ready_fifo_t *fifo, int k);
+
+void save_ready_heap(ready_heap_t *heap, FILE *file);
+
+int load_ready_heap(ready_heap_t *heap, FILE *file);
+
+void save_ready_fifo(ready_fifo_t *fifo, FILE *file);
+
+int load_ready_fifo(ready_fifo_t *fifo, FILE *file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#define _GNU_SOURCE
+#include "ring.h"
+
+// Records shared between the scheduler and one process
+// the scheduler only moves head, the process only moves tail, and
+// each side sleeps on the other's counter when it has nothing to do
+struct ring {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t process_waiting;
+    uint32_t scheduler_waiting;
+    uint32_t ack;
+    char hash[65];
+    ring_record_t records[RING_RECORDS];
+};
+
+
+// Sleep while word still holds value
+static void futex_wait(uint32_t *word, uint32_t value) {
+    syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+
+// Wake the other side sleeping on word
+static void futex_wake(uint32_t *word) {
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+
+// Wait until word moves away from value, flagging the sleep first so
+// the other side knows to wake us
+static void wait_change(uint32_t *word, uint32_t value, uint32_t *waiting) {
+    while (__atomic_load_n(word, __ATOMIC_SEQ_CST) == value) {
+        __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(word, __ATOMIC_SEQ_CST) == value) {
+            futex_wait(word, value);
+        }
+        __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+    }
+}
+
+
+// Move word on, waking the other side only when it sleeps
+static void publish(uint32_t *word, uint32_t value, uint32_t *waiting) {
+    __atomic_store_n(word, value, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        futex_wake(word);
+    }
+}
+
+
+// Create ring in a memory file, closed on exec unless the child it is
+// for keeps it open across its own
+ring_t *create_ring(int *fd) {
+    *fd = memfd_create("ring", MFD_CLOEXEC);
+    if (*fd == -1 || ftruncate(*fd, sizeof(ring_t)) == -1) {
+        perror("memfd_create");
+        exit(EXIT_FAILURE);
+    }
+    ring_t *ring = map_ring(*fd);
+    memset(ring, 0, sizeof(ring_t));
+    return ring;
+}
+
+
+// Map ring from memory file
+ring_t *map_ring(int fd) {
+    ring_t *ring = mmap(NULL, sizeof(ring_t), PROT_READ | PROT_WRITE, 
+                        MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    return ring;
+}
+
+
+// Unmap ring, the memory file goes with its last mapping
+void free_ring(ring_t *ring) {
+    munmap(ring, sizeof(ring_t));
+}
+
+
+// Add records to the ring, waiting only while it is full
+void push_ring(ring_t *ring, int op, uint64_t from, uint32_t step, 
+               uint32_t count) {
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+    while (head - tail == RING_RECORDS) {
+        wait_change(&ring->tail, tail, &ring->scheduler_waiting);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+    }
+
+    ring_record_t *record = &ring->records[head % RING_RECORDS];
+    record->op = op;
+    record->from = from;
+    record->step = step;
+    record->count = count;
+    publish(&ring->head, head + 1, &ring->process_waiting);
+}
+
+
+// Wait until the process has taken every record
+// return low byte of the last time it acknowledged
+uint8_t drain_ring(ring_t *ring) {
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+    while (tail != ring->head) {
+        wait_change(&ring->tail, tail, &ring->scheduler_waiting);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+    }
+    return ring->ack;
+}
+
+
+// Wait for the next record and copy it out, it stays in the ring
+// until acknowledged
+void pop_ring(ring_t *ring, ring_record_t *record) {
+    uint32_t tail = ring->tail;
+    wait_change(&ring->head, tail, &ring->process_waiting);
+    *record = ring->records[tail % RING_RECORDS];
+}
+
+
+// Acknowledge the record taken by pop_ring, leaving hash when given
+void ack_ring(ring_t *ring, uint8_t ack, const char *hash) {
+    ring->ack = ack;
+    if (hash != NULL) memcpy(ring->hash, hash, sizeof(ring->hash));
+    publish(&ring->tail, ring->tail + 1, &ring->scheduler_waiting);
+}
+
+
+// Copy hash left by the process with its last record
+void get_ring_hash(ring_t *ring, char *hash) {
+    memcpy(hash, ring->hash, sizeof(ring->hash));
+    hash[64] = '\0';
+}
\ No newline at end of file
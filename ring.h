@@ -0,0 +1,42 @@
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define RING_RECORDS 64
+
+// Run of count records of one op, times from, from + step and so on
+typedef struct ring_record {
+    uint32_t op;
+    uint32_t step;
+    uint64_t from;
+    uint32_t count;
+} ring_record_t;
+
+typedef struct ring ring_t;
+
+ring_t *create_ring(int *fd);
+
+ring_t *map_ring(int fd);
+
+void free_ring(ring_t *ring);
+
+void push_ring(ring_t *ring, int op, uint64_t from, uint32_t step, 
+               uint32_t count);
+
+uint8_t drain_ring(ring_t *ring);
+
+void pop_ring(ring_t *ring, ring_record_t *record);
+
+void ack_ring(ring_t *ring, uint8_t ack, const char *hash);
+
+void get_ring_hash(ring_t *ring, char *hash);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "scan.h"
+
+// Scans over contiguous per process arrays, times taking 64 bits
+// AVX2 takes 4 processes a step, SSE4.2 2, with scalar code for the rest
+// so a scan gains 2-4x at best, and the count is bound by memory reads
+
+
+// Check one process has arrived, is unfinished and has memory
+static int is_eligible(long long *arrival, int *finished, int *allocated, 
+                       int i, long long time) {
+    return arrival[i] <= time && finished[i] == 0 && allocated[i] != 0;
+}
+
+
+// Check one process counts as remaining, see count_remaining
+static int is_remaining(long long *arrival, long long *slot, int *aligned, 
+                        int *finished, int i, long long time, 
+                        long long limit) {
+    return arrival[i] < time && finished[i] == 0 && 
+           (aligned[i] != 0 || slot[i] < limit);
+}
+
+
+#ifdef SCAN_X86
+
+// Load 4 flags widened to one 64 bit lane each
+__attribute__((target("avx2")))
+static __m256i load_flags_avx2(int *flags) {
+    return _mm256_cvtepi32_epi64(_mm_loadu_si128((__m128i *)flags));
+}
+
+
+// Find first eligible process 4 at a time
+__attribute__((target("avx2")))
+static int find_eligible_avx2(long long *arrival, int *finished, 
+                              int *allocated, int from, int to, 
+                              long long time) {
+
+    __m256i now = _mm256_set1_epi64x(time);
+    __m256i zero = _mm256_setzero_si256();
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(arrival + i));
+        __m256i f = load_flags_avx2(finished + i);
+        __m256i m = load_flags_avx2(allocated + i);
+
+        // not arrived, finished or without memory rules a process out
+        __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(a, now), 
+                      _mm256_or_si256(
+                          _mm256_xor_si256(_mm256_cmpeq_epi64(f, zero), 
+                                           _mm256_set1_epi64x(-1)), 
+                          _mm256_cmpeq_epi64(m, zero)));
+        int mask = ~_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 0xF;
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    for (; i < to; i++) {
+        if (is_eligible(arrival, finished, allocated, i, time)) return i;
+    }
+    return -1;
+}
+
+
+// Count remaining processes 4 at a time
+__attribute__((target("avx2")))
+static int count_remaining_avx2(long long *arrival, long long *slot, 
+                                int *aligned, int *finished, int n, 
+                                long long time, long long limit) {
+
+    __m256i now = _mm256_set1_epi64x(time);
+    __m256i last = _mm256_set1_epi64x(limit);
+    __m256i zero = _mm256_setzero_si256();
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(arrival + i));
+        __m256i s = _mm256_loadu_si256((__m256i *)(slot + i));
+        __m256i g = load_flags_avx2(aligned + i);
+        __m256i f = load_flags_avx2(finished + i);
+
+        // arrived before now, unfinished and in an earlier quantum
+        __m256i in = _mm256_and_si256(_mm256_cmpgt_epi64(now, a), 
+                                      _mm256_cmpeq_epi64(f, zero));
+        __m256i ready = _mm256_or_si256(
+            _mm256_xor_si256(_mm256_cmpeq_epi64(g, zero), 
+                             _mm256_set1_epi64x(-1)), 
+            _mm256_cmpgt_epi64(last, s));
+        in = _mm256_and_si256(in, ready);
+        count += __builtin_popcount(
+            _mm256_movemask_pd(_mm256_castsi256_pd(in)));
+    }
+    for (; i < n; i++) {
+        count += is_remaining(arrival, slot, aligned, finished, i, time, 
+                              limit);
+    }
+    return count;
+}
+
+
+// Load 2 flags widened to one 64 bit lane each
+__attribute__((target("sse4.2")))
+static __m128i load_flags_sse42(int *flags) {
+    return _mm_cvtepi32_epi64(_mm_loadl_epi64((__m128i *)flags));
+}
+
+
+// Find first eligible process 2 at a time
+__attribute__((target("sse4.2")))
+static int find_eligible_sse42(long long *arrival, int *finished, 
+                               int *allocated, int from, int to, 
+                               long long time) {
+
+    __m128i now = _mm_set1_epi64x(time);
+    __m128i zero = _mm_setzero_si128();
+    int i = from;
+    for (; i + 2 <= to; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(arrival + i));
+        __m128i f = load_flags_sse42(finished + i);
+        __m128i m = load_flags_sse42(allocated + i);
+
+        // not arrived, finished or without memory rules a process out
+        __m128i out = _mm_or_si128(_mm_cmpgt_epi64(a, now), 
+                      _mm_or_si128(_mm_andnot_si128(
+                                       _mm_cmpeq_epi64(f, zero), 
+                                       _mm_set1_epi64x(-1)), 
+                                   _mm_cmpeq_epi64(m, zero)));
+        int mask = ~_mm_movemask_pd(_mm_castsi128_pd(out)) & 0x3;
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    for (; i < to; i++) {
+        if (is_eligible(arrival, finished, allocated, i, time)) return i;
+    }
+    return -1;
+}
+
+
+// Count remaining processes 2 at a time
+__attribute__((target("sse4.2")))
+static int count_remaining_sse42(long long *arrival, long long *slot, 
+                                 int *aligned, int *finished, int n, 
+                                 long long time, long long limit) {
+
+    __m128i now = _mm_set1_epi64x(time);
+    __m128i last = _mm_set1_epi64x(limit);
+    __m128i zero = _mm_setzero_si128();
+    int count = 0;
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *)(arrival + i));
+        __m128i s = _mm_loadu_si128((__m128i *)(slot + i));
+        __m128i g = load_flags_sse42(aligned + i);
+        __m128i f = load_flags_sse42(finished + i);
+
+        // arrived before now, unfinished and in an earlier quantum
+        __m128i in = _mm_and_si128(_mm_cmpgt_epi64(now, a), 
+                                   _mm_cmpeq_epi64(f, zero));
+        __m128i ready = _mm_or_si128(
+            _mm_andnot_si128(_mm_cmpeq_epi64(g, zero), 
+                             _mm_set1_epi64x(-1)), 
+            _mm_cmpgt_epi64(last, s));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(in, 
+                                                                  ready)));
+        count += __builtin_popcount(mask);
+    }
+    for (; i < n; i++) {
+        count += is_remaining(arrival, slot, aligned, finished, i, time, 
+                              limit);
+    }
+    return count;
+}
+
+#endif
+
+
+// Find first process in [from, to) which arrived by time, is not
+// finished and has memory, -1 when there is none
+int find_eligible(long long *arrival, int *finished, int *allocated, 
+                  int from, int to, long long time) {
+#ifdef SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return find_eligible_avx2(arrival, finished, allocated, from, to, 
+                                  time);
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return find_eligible_sse42(arrival, finished, allocated, from, to, 
+                                   time);
+    }
+#endif
+    for (int i = from; i < to; i++) {
+        if (is_eligible(arrival, finished, allocated, i, time)) return i;
+    }
+    return -1;
+}
+
+
+// Count unfinished processes arrived before time which are aligned to
+// a quantum or whose arrival quantum slot is below limit
+int count_remaining(long long *arrival, long long *slot, int *aligned, 
+                    int *finished, int n, long long time, long long limit) {
+#ifdef SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return count_remaining_avx2(arrival, slot, aligned, finished, n, 
+                                    time, limit);
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return count_remaining_sse42(arrival, slot, aligned, finished, n, 
+                                     time, limit);
+    }
+#endif
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += is_remaining(arrival, slot, aligned, finished, i, time, 
+                              limit);
+    }
+    return count;
+}
\ No newline at end of file
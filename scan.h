@@ -0,0 +1,18 @@
+#ifndef _SCAN_H_
+#define _SCAN_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+int find_eligible(long long *arrival, int *finished, int *allocated, 
+                  int from, int to, long long time);
+
+int count_remaining(long long *arrival, long long *slot, int *aligned, 
+                    int *finished, int n, long long time, long long limit);
+
+#endif
\ No newline at end of file
@@ -1,4 +1,17 @@
+#define _GNU_SOURCE
 #include "schedule.h"
+#include "policy.h"
+#include "checkpoint.h"
+
+// handshakes as process.c stores them into its hash ring
+#define OP_START 0
+#define OP_STOP 1
+#define OP_CONTINUE 2
+#define OP_TERM 3
+#define HASH_RING (128 - 9)
+
+// digests checked at once, one per lane of the widest sha256 kernel
+#define HASH_GROUP 8
 
 struct child {
 
@@ -7,546 +20,915 @@ struct child {
     int pipe_from_child[2];
 
     pid_t pid;
-    uint32_t simulation_time_big_endian;
+
+    // quanta run without a handshake, sent as one span later
+    int pending;
+    long long pending_from;
+    long long pending_step;
+
+    // real process runs without leftover checks and syncs
+    int fast;
+
+    // real process burns cpu while running instead of blocking
+    int spin;
+
+    // cpus real process is kept on, none means any
+    int *cpus;
+    int num_cpus;
+
+    // real process takes its times from a shared ring, not the pipes
+    int shared;
+    int stopped;
+    ring_t *shared_ring;
+
+    // simulated process keeps the hash ring itself, as does a real
+    // process whose digest is checked
+    int simulated;
+    uint8_t ring[128];
+    size_t ring_index;
+    hash_check_t *check;
+    char *name;
 
 };
 
 
-// Scheduling mode decision
-void start_scheduling(process_t **process, char *scheduler, 
-                      int num, int quantum, char *mem_strategy) {
+// Digests real processes reported, held until a whole group can be
+// hashed again from the handshakes recorded for them
+struct hash_check {
+    uint8_t content[HASH_GROUP][HASH_RING];
+    char reported[HASH_GROUP][65];
+    char *name[HASH_GROUP];
+    int pending;
+    int checked;
+    int mismatched;
+};
+
+
+// Check run needs none of the general engine's optional features
+static int is_plain_run(options_t *opts) {
+    return opts->checkpoint == NULL && opts->resume == NULL && 
+           opts->daemon == NULL && opts->metrics == NULL && 
+           opts->pace == 0 && !opts->compact && 
+           strcmp(opts->mem_strategy, "paged") != 0;
+}
+
+
+// Scheduling mode decision, writing the run's output to out
+// totals are also kept in stats unless it is NULL
+// in daemon mode process has room for max_jobs, and num are given
+void start_scheduling(process_t **process, int num, options_t *opts, 
+                      arena_t *arena, FILE *out, run_stats_t *stats) {
+
+    // daemon is given room for processes submitted while it runs
+    int capacity = opts->daemon != NULL ? opts->max_jobs : num;
 
     // initiate current time from 0
     // assume all processes are not finished yet
-    int current_time = 0;
-    int is_finished[num];
-    memset(is_finished, 0, sizeof(is_finished));
+    long long current_time = 0;
+    int *is_finished = arena_calloc(arena, capacity, sizeof(int));
 
-    // statistics
-    int turnaround = 0;
-    double max_overhead = 0.0;
-    double total_overhead = 0.0;
+    // create mem allocation when using best-fit
+    mem_table_t *memory = NULL;
+    if (strcmp(opts->mem_strategy, "best-fit") == 0) {
+        memory = create_mem_table(arena);
+    }
 
     // determine scheduler
-    if (strcmp(scheduler, "SJF") == 0) {
-        do_sjf(process, num, quantum, &current_time, is_finished, 
-               mem_strategy, &turnaround, &max_overhead, &total_overhead);
-    } else if (strcmp(scheduler, "RR") == 0) {
-        do_rr(process, num, quantum, &current_time, is_finished, 
-              mem_strategy, &turnaround, &max_overhead, &total_overhead);
+    sched_ops_t *ops = find_policy(opts->scheduler);
+    if (ops == NULL) {
+        fprintf(stderr, "Unknown scheduler %s\n", opts->scheduler);
+        exit(EXIT_FAILURE);
     }
 
-    // print out statistics
-    if (turnaround % num != 0) {
-        turnaround /= num;
+    // real processes can not be saved and brought back
+    if ((opts->checkpoint != NULL || opts->resume != NULL) && 
+        !opts->simulate) {
+        fprintf(stderr, "Checkpoints need --simulate\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((opts->checkpoint != NULL || opts->resume != NULL) && 
+        opts->daemon != NULL) {
+        fprintf(stderr, "Checkpoints are not kept in daemon mode\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // policies may run processes in their own fixed order
+    // submitted processes are left in the order they came
+    if (ops->compare != NULL && opts->daemon == NULL) {
+        qsort(process, num, sizeof(*process), ops->compare);
+    }
+
+    run_t *run = create_run(process, num, capacity, opts, arena, out, 
+                            &current_time, is_finished, memory);
+    if (opts->daemon != NULL) run->server = open_server(opts->daemon);
+
+    // plain runs take the loop built for their policy and children,
+    // so no option is looked at between quanta
+    if (!is_plain_run(opts)) {
+        run_engine(run, ops);
+    } else if (opts->simulate) {
+        ops->simulated_engine(run);
+    } else {
+        ops->real_engine(run);
+    }
+    if (run->server != NULL) close_server(run->server);
+    num = run->n;
+    long long turnaround = get_stats_turnaround(run->stats);
+    double max_overhead = get_stats_max_overhead(run->stats);
+    double total_overhead = get_stats_total_overhead(run->stats);
+
+    // keep totals for a batch summary
+    if (stats != NULL) {
+        stats->processes = num;
+        stats->turnaround = turnaround;
+        stats->max_overhead = max_overhead;
+        stats->total_overhead = total_overhead;
+        stats->makespan = current_time;
+    }
+
+    // print out statistics, a daemon may have run none
+    int count = num > 0 ? num : 1;
+    if (turnaround % count != 0) {
+        turnaround /= count;
         turnaround ++;
     } else {
-        turnaround /= num;
+        turnaround /= count;
     }
-    printf("Turnaround time %d\nTime overhead %.2lf %.2lf\nMakespan %d\n", 
-            turnaround, 
+    fprintf(out, "Turnaround time %lld\nTime overhead %.2lf %.2lf\n"
+            "Makespan %lld\n", turnaround, 
             round(max_overhead * 100) / 100, 
-            round(total_overhead * 100 / num) / 100, current_time);
+            round(total_overhead * 100 / count) / 100, current_time);
+
+    // print memory statistics next to the rest
+    if (memory != NULL) {
+        sample_mem(memory, current_time);
+        if (opts->mem_stats) {
+            print_mem_summary(out, memory);
+        }
+    }
+    if (run->pages != NULL && opts->mem_stats) {
+        print_page_summary(out, run->pages);
+    }
+    if (run->pacer != NULL) {
+        print_pace_summary(out, run->pacer);
+    }
+    if (run->hash_check != NULL) {
+        print_hash_summary(out, run->hash_check);
+    }
 
-    // free all process and process array
-    for (int i = 0; i < num; i++) {
-        free(process[i]);
+    // quantiles of per process metrics
+    if (opts->stats) {
+        print_stats(out, run->stats);
     }
-    free(process);
 
 }
 
-// Run processes in Shortest Job First
-void do_sjf(process_t **p, int n, int q, int *time, 
-            int *is_finished, char *strategy,
-            int *turnaround, double *max_overhead, double *total_overhead) {
 
-    // sort processes ascending by service time
-    qsort(p, n, sizeof(*p), compare_service_time);
+// Set up state of process i from its trace entry
+static void init_process(run_t *run, int i) {
+
+    options_t *opts = run->opts;
+    process_t *p = run->p[i];
 
-    // create and initialize mem allocation
-    int use_strategy = 0;
-    int mem_allocated[n];
-    memory_t **memory;
-    if (strcmp(strategy, "best-fit") == 0) {
-        use_strategy = 1;
-        memory = create_mem_table();
-        memset(mem_allocated, 0, sizeof(mem_allocated));
+    // service time as remain time at beginning
+    run->remain_time[i] = get_service_time(p);
+    run->is_finished[i] = 0;
+    run->mem_allocated[i] = 0;
+    run->arrival[i] = get_arrival_time(p);
+    run->size[i] = get_process_mem(p);
+    run->slot[i] = run->arrival[i] / opts->quantum;
+    run->aligned[i] = run->arrival[i] % opts->quantum == 0;
+
+    // children start on first run
+    child_t *child = run->child[i];
+    child->in_use = 0;
+    child->simulated = opts->simulate;
+    child->fast = opts->fast_process;
+    child->spin = opts->pace > 0;
+
+    // one cpu each in turn when spread, else share all given
+    if (opts->spread && opts->num_child_cpus > 0) {
+        child->cpus = &opts->child_cpus[i % opts->num_child_cpus];
+        child->num_cpus = 1;
+    } else {
+        child->cpus = opts->child_cpus;
+        child->num_cpus = opts->num_child_cpus;
+    }
+    child->shared = opts->shm_transport;
+    child->check = run->hash_check;
+}
+
+
+// Set up state shared by every scheduler for one run
+// with room for capacity processes, the first n given now
+run_t *create_run(process_t **p, int n, int capacity, options_t *opts, 
+                  arena_t *arena, FILE *out, long long *time, 
+                  int *is_finished, mem_table_t *memory) {
+
+    run_t *run = arena_alloc(arena, sizeof(run_t));
+    run->p = p;
+    run->n = n;
+    run->slots = n;
+    run->capacity = capacity;
+    run->opts = opts;
+    run->arena = arena;
+    run->out = out;
+    run->scratch = create_scratch(arena, SCRATCH_CHUNK);
+    run->time = time;
+    run->is_finished = is_finished;
+    run->stats = create_stats(arena);
+    run->pacer = NULL;
+    run->metrics = NULL;
+    run->events = 0;
+    run->server = NULL;
+    run->free_slots = NULL;
+    run->num_free = 0;
+    run->hash_check = NULL;
+    if (opts->verify_hashes && !opts->simulate) {
+        run->hash_check = arena_calloc(arena, 1, sizeof(hash_check_t));
     }
 
-    // run in sjf scheduling
+    // processes wait in arrival order until they get memory
+    run->remain_time = arena_alloc(arena, capacity * sizeof(long long));
+    run->memory = memory;
+    run->pages = NULL;
+    if (strcmp(opts->mem_strategy, "paged") == 0) {
+        run->pages = create_page_table(capacity, arena);
+    }
+    run->mem_allocated = arena_alloc(arena, capacity * sizeof(int));
+    run->memstart = arena_alloc(arena, capacity * sizeof(int));
+    run->arrival = arena_alloc(arena, capacity * sizeof(long long));
+    run->size = arena_alloc(arena, capacity * sizeof(int));
+    run->admitted = arena_alloc(arena, capacity * sizeof(int));
+    run->slot = arena_alloc(arena, capacity * sizeof(long long));
+    run->aligned = arena_alloc(arena, capacity * sizeof(int));
+    run->child = arena_alloc(arena, capacity * sizeof(child_t *));
+    child_t *storage = arena_alloc(arena, capacity * sizeof(child_t));
+    for (int i = 0; i < capacity; i++) {
+        run->child[i] = &storage[i];
+    }
     for (int i = 0; i < n; i++) {
+        init_process(run, i);
+    }
+
+    // daemon starts with none, submitted ones join as they come
+    if (opts->daemon != NULL) {
+        run->queue = create_open_queue(capacity, run->arrival, run->size, 
+                                       arena);
+        run->free_slots = arena_alloc(arena, capacity * sizeof(int));
+    } else {
+        run->queue = create_wait_queue(n, run->arrival, run->size, arena);
+    }
+    run->admitted_until = -1;
+    run->order = get_arrival_order(run->queue);
+    run->fed = 0;
+    run->idle = 0;
+    run->live = 0;
+    run->last = -1;
+
+    // policy sets up its own ready structures
+    run->current = -1;
+    run->cursor = 0;
+    run->seq = 0;
+    run->finished = 0;
+    run->backfilled = 0;
+    run->heap = NULL;
+    run->fifo = NULL;
+    run->levels = NULL;
+    run->slice = 0;
+    run->slice_used = 0;
+    run->slice_ready = 0;
+    run->service_quanta = NULL;
+    run->service_count = 0;
+
+    return run;
+}
+
+
+// Get next arrival after current time, LLONG_MAX when none is left
+static long long next_arrival(run_t *run) {
+    while (run->idle < run->n && 
+           run->arrival[run->order[run->idle % run->capacity]] <= 
+           *run->time) {
+        run->idle++;
+    }
+    if (run->idle == run->n) return LLONG_MAX;
+    return run->arrival[run->order[run->idle % run->capacity]];
+}
 
-        int process_running = 0;
-        int j, memstart;
 
-        // initialize child and pipeline
-        int pipe_to_child[2];
-        int pipe_from_child[2];
-        pipe(pipe_to_child);
-        pipe(pipe_from_child);
+// Take processes submitted since the last boundary, arriving now
+// waiting for some first if asked
+// return number taken, -1 once the client is done and none are left
+static int receive_jobs(run_t *run, int wait) {
+
+    submission_t *jobs;
+    int count = take_submissions(run->server, &jobs, wait);
+    for (int k = 0; k < count; k++) {
+        submission_t *job = &jobs[k];
+
+        // no room left, or process could never be given memory
+        if ((run->slots == run->capacity && run->num_free == 0) || 
+            job->service < 1 || job->memory < 1 || 
+            !can_hold(run, job->memory)) {
+            char event[MAX_SUBMIT_LINE];
+            int length = snprintf(event, sizeof(event), 
+                                  "%lld,REJECTED,process_name=%s\n", 
+                                  *run->time, job->name);
+            send_event(run->server, event, length);
+            continue;
+        }
 
-        pid_t pid;
-        uint32_t simulation_time_big_endian;
+        // slot of a finished process first, it may have run last
+        int i;
+        if (run->num_free > 0) {
+            i = run->free_slots[--run->num_free];
+            if (run->last == i) run->last = -1;
+        } else {
+            i = run->slots++;
+        }
 
-        // search arrived process
-        for (j = 0; j < n; j++) {
-            if (get_arrival_time(p[j]) <= *time && 
-                is_finished[j] == 0) {
+        // appended in arrival order, so the trace order holds
+        set_process(run->p[i], *run->time, job->name, job->service, 
+                    job->memory, job->priority);
+        init_process(run, i);
+        add_arrival(run->queue, i);
+        run->n++;
+    }
+    return count;
+}
 
-                // alloc mem when using best-fit
-                if (use_strategy) {
-                    if (!mem_allocated[j]) {
-                        memstart = allocate_mem(memory, 
-                                                get_process_mem(p[j]));
-                        print_ready_msg(*time, get_process_name(p[j]), 
-                                        memstart);
-                        mem_allocated[j] = 1;
-                    }
-                }
 
-                // create child process
-                pid = fork();
+// Get number of quanta process i needs to finish, at most INT_MAX
+// as longer ones run as several spans
+int get_quanta_left(run_t *run, int i) {
+    long long q = run->opts->quantum;
+    long long need = run->remain_time[i] / q + 
+                     (run->remain_time[i] % q != 0);
+    return need < INT_MAX ? need : INT_MAX;
+}
 
-                // child process
-                if (pid == 0) {
 
-                    // open pipeline
-                    dup2(pipe_to_child[0], STDIN_FILENO);
-                    dup2(pipe_from_child[1], STDOUT_FILENO);
-                    close(pipe_to_child[1]);
-                    close(pipe_from_child[0]);
+// Cut span of quanta to end at the quantum boundary reaching
+// next arrival or the policy's event
+int cap_span(run_t *run, int span, long long event) {
 
-                    // run prebuilt process exec
-                    char *pargv[] = {"./process", 
-                                     get_process_name(p[j]), 
-                                     NULL};
-                    execvp(pargv[0], pargv);
+    long long limit = next_arrival(run);
+    if (event < limit) limit = event;
+    if (limit == LLONG_MAX) return span;
 
-                } 
-                
-                // main process
-                else {
+    // boundaries before limit, plus the quantum already started
+    long long cap = 1 + (limit - *run->time - 1) / run->opts->quantum;
+    if (cap < 1) cap = 1;
+    return cap < span ? cap : span;
+}
 
-                    close(pipe_to_child[0]);
-                    close(pipe_from_child[1]);
 
-                    // send current time to child
-                    simulation_time_big_endian = htonl(*time);
-                    write(pipe_to_child[1], &simulation_time_big_endian, 
-                          sizeof(uint32_t));
+// Move time on to next arrival while nothing can run
+void skip_to_arrival(run_t *run) {
+    long long next = next_arrival(run);
+    if (next == LLONG_MAX) {
+        fprintf(stderr, "No process can be run at time %lld\n", *run->time);
+        exit(EXIT_FAILURE);
+    }
+    *run->time = next;
+}
 
-                    // get and validate response
-                    uint8_t response;
-                    read(pipe_from_child[0], &response, sizeof(response));
 
-                    // exit if mismatched
-                    if (response != (*time & 0xFF)) exit(EXIT_FAILURE);
+// Get number of quanta process i can run before anything may change
+// span ends at the quantum boundary reaching next arrival or event
+static int get_span(run_t *run, sched_ops_t *ops, int i) {
 
-                }
+    int need = get_quanta_left(run, i);
 
-                // print process running message
-                process_running = 1;
-                print_running_msg(*time, get_service_time(p[j]), 
-                                  get_process_name(p[j]));
+    // another process may take over at the next boundary
+    if (need <= 1 || (ops->contended != NULL && ops->contended(run, i))) {
+        return 1;
+    }
 
-                // quantum controlling on real process
-                int start_time = *time;
-                *time = *time + q;
+    // compaction may admit waiting processes at any boundary
+    if (run->opts->compact && get_num_waiting(run->queue) > 0) return 1;
 
-                // continue running until finished
-                while (*time - start_time < get_service_time(p[j])) {
+    // paced runs wait out every quantum on its own
+    // and a daemon takes submissions at every boundary
+    if (run->pacer != NULL || run->server != NULL) return 1;
 
-                    simulation_time_big_endian = htonl(*time);
+    long long event = ops->next_event != NULL ? ops->next_event(run) : 
+                      LLONG_MAX;
+    return cap_span(run, need, event);
+}
 
-                    // send current time for child to continue
-                    write(pipe_to_child[1], &simulation_time_big_endian, 
-                          sizeof(uint32_t));
-                    kill(pid, SIGCONT);
 
-                    // get and validate response
-                    uint8_t response;
-                    read(pipe_from_child[0], &response, sizeof(response));
+// Publish counters and gauges of the run to the metrics file
+static void export_metrics(run_t *run, int done) {
+
+    metrics_page_t values;
+    values.done = done;
+    values.events = run->events;
+    values.finished = run->finished;
+    values.time = *run->time;
+
+    // arrived and not finished, and those of them without memory
+    next_arrival(run);
+    values.ready = run->idle - run->finished;
+    values.waiting = get_num_waiting(run->queue);
+    values.live_children = run->live;
+    values.mem_used = 0;
+    values.largest_hole = 0;
+    if (run->memory != NULL) {
+        values.mem_used = get_mem_live(run->memory);
+        values.largest_hole = get_mem_largest_hole(run->memory);
+    } else if (run->pages != NULL) {
+        values.mem_used = (NUM_FRAMES - get_free_frames(run->pages)) * 
+                          PAGE_SIZE;
+    }
+    publish_metrics(run->metrics, &values);
+}
 
-                    // exit if mismatched
-                    if (response != (*time & 0xFF)) exit(EXIT_FAILURE);
 
-                    *time = *time + q;
+// Run processes as the policy's hooks decide, jumping between events
+// quanta where nothing can change run as a single span
+void run_engine(run_t *run, sched_ops_t *ops) {
 
-                }
+    options_t *opts = run->opts;
+    long long q = opts->quantum;
+    long long *remain_time = run->remain_time;
+    if (ops->init != NULL) ops->init(run);
 
-                // process finished after service (+q) time
-                is_finished[j] = 1;
-                break;
+    // carry on from saved state
+    if (opts->resume != NULL) load_checkpoint(run, opts->resume);
+    run->next_checkpoint = *run->time + opts->checkpoint_every;
 
-            }
+    // wall clock starts from where simulated time is now
+    if (opts->pace > 0) {
+        run->pacer = create_pacer(opts->pace * 1000LL, *run->time, 
+                                  run->arena);
+    }
+    if (opts->metrics != NULL) {
+        run->metrics = open_metrics(opts->metrics, run->arena);
+    }
+
+    // run until all finished, a daemon until its client is done
+    // and waiting for submissions while there is nothing to run
+    while (run->finished < run->n || 
+           (run->server != NULL && receive_jobs(run, 1) != -1)) {
+
+        // admit what was submitted during the last quantum
+        if (run->server != NULL) receive_jobs(run, 0);
+
+        // scrapers see the state between events
+        run->events++;
+        if (run->metrics != NULL) export_metrics(run, 0);
+
+        // save state between events
+        if (opts->checkpoint != NULL && *run->time >= run->next_checkpoint) {
+            save_checkpoint(run, opts->checkpoint);
+            run->next_checkpoint = *run->time + opts->checkpoint_every;
         }
 
-        // patch if process not run but time counts
-        if (!process_running) {
-            *time = *time + 1;
-            i--;
+        if (ops->admit != NULL) ops->admit(run);
+        int i = ops->pick_next(run);
+
+        // idle until next process arrives
+        if (i == -1) {
+
+            // daemon has nothing to run until more is submitted
+            if (run->server != NULL && next_arrival(run) == LLONG_MAX && 
+                (receive_jobs(run, 1) != -1 || run->finished == run->n)) {
+                continue;
+            }
+            skip_to_arrival(run);
+            if (run->pacer != NULL) pace_until(run->pacer, *run->time);
             continue;
         }
 
-        // avoid readings beyond the process array
-        if (j == n) break;
+        // update current time to the end of the span
+        // update remain time for current process
+        int span = get_span(run, ops, i);
+        dispatch_process(run, i, span);
+        *run->time = *run->time + (long long)span * q;
+        remain_time[i] -= (long long)span * q;
+        if (run->pacer != NULL) pace_until(run->pacer, *run->time);
+
+        // process finish
+        if (remain_time[i] <= 0) {
+            if (ops->on_finish != NULL) ops->on_finish(run, i);
+            finish_process(run, i);
+            run->finished++;
+        } else if (ops->on_quantum_end != NULL) {
+            ops->on_quantum_end(run, i, span);
+        }
+    }
 
-        // using best-fit when capable
-        if (use_strategy) {
+    if (run->pacer != NULL) close_pacer(run->pacer);
+    if (run->metrics != NULL) {
+        export_metrics(run, 1);
+        close_metrics(run->metrics);
+    }
 
-            // store process ready and alloc in runtime
-            int count = 0;
-            int *original_index = malloc(n * sizeof(int));
-            process_t **runtime = malloc(n * sizeof(process_t *));
+}
 
-            for (int k = 0; k < n; k++) {
 
-                if (mem_allocated[k]) continue;
+// Check memory could ever hold a process of size
+// infinite memory always can
+int can_hold(run_t *run, int size) {
+    if (run->pages != NULL) return get_page_count(size) <= NUM_FRAMES;
+    if (run->memory != NULL) return size <= MAX_MEMORY;
+    return 1;
+}
 
-                // check if new process are ready
-                if (get_arrival_time(p[k]) <= *time - q) {
-                    runtime[count] = p[k];
-                    original_index[count] = k;
-                    count++;
-                }
 
-            }
+// Give best-fit memory to waiting process j, making room by compaction
+// when asked and worth it, return 1 when it got memory
+static int give_memory(run_t *run, int j) {
 
-            // re-sort by arrival time to align input sequence
-            // print process ready message
-            qsort(runtime, count, sizeof(*runtime), compare_arrival_time);
-            for (int x = 0; x < count; x++) {
-                print_ready_msg(get_arrival_time(runtime[x]), 
-                                get_process_name(runtime[x]), 
-                                allocate_mem(memory, 
-                                             get_process_mem(runtime[x])));
-                mem_allocated[original_index[x]] = 1;
-            }
+    mem_table_t *memory = run->memory;
+    sample_mem(memory, *run->time);
+    run->memstart[j] = allocate_mem(memory, run->size[j]);
+    if (run->memstart[j] == -1 && run->opts->compact && 
+        try_compaction(run, j)) {
+        run->memstart[j] = allocate_mem(memory, run->size[j]);
+    }
+    if (run->memstart[j] == -1) return 0;
+
+    // alloc process mem
+    remove_waiting(run->queue, j);
+    print_ready_msg(run->out, *run->time, get_process_name(run->p[j]), 
+                    run->memstart[j]);
+    if (run->opts->mem_sample) {
+        print_mem_msg(run->out, *run->time, memory);
+    }
+    run->mem_allocated[j] = 1;
+    return 1;
+}
 
-            // clear current finished process mem block
-            clear_mem(memory, memstart, get_process_mem(p[j]));
 
-            // free temp runtime list 
-            free(runtime);
-            free(original_index);
+// Give memory to arrived processes which fit, in arrival order
+// return number admitted, listed in run's admitted array
+int admit_waiting(run_t *run) {
 
-        }
+    options_t *opts = run->opts;
+    mem_table_t *memory = run->memory;
+    wait_queue_t *queue = run->queue;
+    int arrived = admit_arrivals(queue, *run->time);
+    int count = 0;
 
-        // print process result
-        print_result_msg(n, q, *time, p, is_finished, 
-                         get_process_name(p[j]));
+    // only walk waiting processes when one could fit
+    if (memory != NULL && arrived == 0 && !opts->compact && 
+        get_min_waiting(queue) > get_mem_largest_hole(memory)) {
+        return 0;
+    }
 
-        // terminate child process
-        simulation_time_big_endian = htonl(*time);
-        write(pipe_to_child[1], &simulation_time_big_endian, 
-                                 sizeof(uint32_t));
-        kill(pid, SIGTERM);
+    // without compaction holes only shrink as memory is given, so the
+    // next to admit is always the earliest fitting the largest hole
+    if (memory != NULL && !opts->compact) {
 
-        // wait child to terminate
-        int status;
-        waitpid(pid, &status, 0);
-
-        // read 64-byte string from child 
-        char sha[65];
-        read(pipe_from_child[0], sha, 64);
-        sha[64] = '\0';
-
-        // print sha
-        printf("%d,FINISHED-PROCESS,process_name=%s,sha=%s\n", 
-            *time, get_process_name(p[j]), 
-            sha);
-
-        // close pipeline
-        close(pipe_to_child[1]);
-        close(pipe_from_child[0]);
-        
-        // calc stats when one process finish
-        *turnaround = *turnaround + (*time - get_arrival_time(p[j]));
-        if ((double)(*time - get_arrival_time(p[j])) / 
-                      get_service_time(p[j]) > *max_overhead) {
-            *max_overhead = (double)(*time - get_arrival_time(p[j])) / 
-                                     (get_service_time(p[j]));
+        // new arrivals are tried once even when they do not fit
+        int fresh = -1;
+        for (int i = last_waiting(queue); 
+             i != -1 && run->arrival[i] > run->admitted_until; 
+             i = prev_waiting(queue, i)) {
+            fresh = i;
+        }
+        while (1) {
+            int j = first_fitting(queue, get_mem_largest_hole(memory));
+            while (fresh != -1 && fresh != j && 
+                   (j == -1 || run->arrival[j] > run->admitted_until)) {
+                give_memory(run, fresh);
+                fresh = next_waiting(queue, fresh);
+            }
+            if (j == -1) break;
+            if (j == fresh) fresh = next_waiting(queue, j);
+            give_memory(run, j);
+            run->admitted[count++] = j;
         }
-        *total_overhead = *total_overhead + (double)
-                                            (*time - get_arrival_time(p[j])) /
-                                                     get_service_time(p[j]);
-        
+        run->admitted_until = *run->time;
+        return count;
     }
 
-    // free memory block's mem
-    if (use_strategy) {
-        free_mem(memory);
+    int j = first_waiting(queue);
+    while (j != -1) {
+        int next = next_waiting(queue, j);
+
+        // assume all mem alloc when in infinity
+        // paged memory takes any process not above every frame
+        if (memory == NULL) {
+            if (!can_hold(run, run->size[j])) {
+                j = next;
+                continue;
+            }
+            remove_waiting(queue, j);
+            run->mem_allocated[j] = 1;
+            run->admitted[count++] = j;
+            j = next;
+            continue;
+        }
+
+        // compaction may make room for any of them
+        if (give_memory(run, j)) run->admitted[count++] = j;
+        j = next;
     }
+    run->admitted_until = *run->time;
+
+    return count;
+}
 
+
+// Load every page of process i, evicting least recently run first
+// return time the fault and evictions take, in whole quanta
+static long long page_in(run_t *run, int i, long long time) {
+
+    page_table_t *pages = run->pages;
+    long long q = run->opts->quantum;
+    touch_process(pages, i);
+    int missing = get_page_count(run->size[i]) - get_resident_pages(pages, i);
+    if (missing == 0) return 0;
+    long long cost = run->opts->fault_cost;
+
+    // process itself is most recent, so comes up only once no other
+    // holds frames, which admission rules out by its size
+    while (get_free_frames(pages) < missing) {
+        int victim = get_lru_process(pages);
+        if (victim == i || victim == -1) break;
+        int evicted = evict_pages(pages, victim, 
+                                  missing - get_free_frames(pages));
+        print_page_msg(run->out, time, "EVICTED", 
+                       get_process_name(run->p[victim]), evicted);
+        cost += run->opts->evict_cost;
+    }
+    if (missing > get_free_frames(pages)) missing = get_free_frames(pages);
+    load_pages(pages, i, missing);
+    print_page_msg(run->out, time, "LOADED", get_process_name(run->p[i]), 
+                   missing);
+
+    if (cost % q != 0) cost += q - cost % q;
+    charge_page_time(pages, cost);
+    return cost;
 }
 
 
-// Run processes in Round Robin
-void do_rr(process_t **p, int n, int q, int *time, 
-           int *is_finished, char *strategy, 
-           int *turnaround, double *max_overhead, double *total_overhead) {
+// Run process i for the next span of quanta, switching from last if needed
+void dispatch_process(run_t *run, int i, int span) {
+
+    child_t **child = run->child;
+    long long q = run->opts->quantum;
+    long long time = *run->time;
+
+    // switch to process for first quantum, unless same one keeps running
+    int first = 0;
+    if (run->last != i) {
+        int64_t started = run->metrics != NULL ? metrics_clock() : 0;
+
+        // suspend process when other ready runs
+        if (run->last != -1 && child[run->last]->in_use) {
+            suspend_child(child[run->last], time);
+        }
+
+        // bring pages in before the process touches them, which holds
+        // the cpu up for as long as that takes
+        if (run->pages != NULL) {
+            time += page_in(run, i, time);
+            *run->time = time;
+        }
 
-    // remain time for each process each round
-    int remain_time[n];
-    int all_finished = 0;
+        // process run first-time or continue run process
+        if (child[i]->in_use == 0) {
+            start_child(child[i], get_process_name(run->p[i]), time);
+            record_start(run->stats, get_arrival_time(run->p[i]), 
+                         get_process_mem(run->p[i]), time);
+            run->live++;
+        } else {
+            send_cont_signal(child, &time, i);
+        }
+        if (run->metrics != NULL) {
+            record_handshake(run->metrics, metrics_clock() - started);
+        }
+        print_running_msg(run->out, time, run->remain_time[i], 
+                          get_process_name(run->p[i]));
 
-    // create and initialize mem allocation
-    int use_strategy = 0;
-    int mem_allocated[n];
-    memory_t **memory;
-    if (strcmp(strategy, "best-fit") == 0) {
-        use_strategy = 1;
-        memory = create_mem_table();
-        memset(mem_allocated, 0, sizeof(mem_allocated));
+        // store previous process key info
+        run->last = i;
+        first = 1;
     }
 
-    // service time as remain time at beginning
-    for (int i = 0; i < n; i++) {
-        remain_time[i] = get_service_time(p[i]);
+    // continue process for rest of span
+    // a span's step between quanta goes out in 32 bits
+    if (first == span) return;
+    if (run->opts->coalesce && q <= UINT32_MAX) {
+        defer_cont_signal(child[i], time + first * q, q, span - first);
+        return;
     }
+    for (int k = first; k < span; k++) {
+        long long at = time + (long long)k * q;
+        send_cont_signal(child, &at, i);
+    }
+}
 
-    // initialize child and pipeline
-    child_t **child = malloc(n * sizeof(child_t *));
-    for (int i = 0; i < n; i++) {
-        child[i] = malloc(sizeof(child_t));
-        pipe(child[i]->pipe_from_child);
-        pipe(child[i]->pipe_to_child);
-        child[i]->in_use = 0;
-    }
-
-    // run until all finished
-    char *last_process = NULL;
-    int last_process_index = 0;
-    while (all_finished == 0) {
-
-        int memstart[n];
-
-        // run each process on given quantum
-        for (int i = 0; i < n; i++) {
-            if (get_arrival_time(p[i]) <= *time && 
-                is_finished[i] == 0) {
-
-                // when using best-fit
-                if (use_strategy) {
-                    for (int j = 0; j < n; j++) {
-                        if (!mem_allocated[j] && 
-                             get_arrival_time(p[j]) <= 
-                            *time && is_finished[i] == 0) {
-                            memstart[j] = allocate_mem(memory, 
-                                          get_process_mem(p[j]));
-
-                            // alloc process mem
-                            if (memstart[j] != -1) {
-                                print_ready_msg(*time, 
-                                get_process_name(p[j]), 
-                                                 memstart[j]);
-                                mem_allocated[j] = 1;
-                            }
-                        }
-                    }
-                } else {
-
-                    // assume all mem alloc when in infinity
-                    for (int j = 0; j < n; j ++) {
-                        mem_allocated[j] = 1;
-                    }
-
-                }
-
-                // start run process when its mem has alloc
-                if (mem_allocated[i] && (last_process == NULL || 
-                    strcmp(last_process, get_process_name(p[i])) != 0)) {
-
-                        // suspend process when other ready runs
-                        if (last_process != NULL && 
-                            child[last_process_index]->in_use) {
-
-                            // get current time
-                            child[last_process_index]->
-                            simulation_time_big_endian = htonl(*time);
-
-                            // send time to process
-                            write(child[last_process_index]->pipe_to_child[1], 
-                                 &child[last_process_index]->
-                                  simulation_time_big_endian, 
-                                  sizeof(uint32_t));
-
-                            // send process to suspend
-                            kill(child[last_process_index]->pid, SIGTSTP);
-
-                            // wait till process is been suspended
-                            int wstatus = 0;
-                            waitpid(child[last_process_index]->pid, &wstatus, 
-                                    WUNTRACED);
-                            while (!WIFSTOPPED(wstatus)) {
-                                waitpid(child[last_process_index]->pid, 
-                                       &wstatus, WUNTRACED);
-                            }
-                        }
-
-                    // process run first-time
-                    if (child[i]->in_use == 0) {
-
-                        // create child process
-                        child[i]->in_use = 1;
-                        child[i]->pid = fork();
-
-                        // child process
-                        if (child[i]->pid == 0) {
-
-                            // open pipeline
-                            dup2(child[i]->pipe_to_child[0], STDIN_FILENO);
-                            dup2(child[i]->pipe_from_child[1], STDOUT_FILENO);
-                            close(child[i]->pipe_to_child[1]);
-                            close(child[i]->pipe_from_child[0]);
-
-                            // run prebuilt process exec
-                            char *pargv[] = {"./process", 
-                                              get_process_name(p[i]), 
-                                              NULL};
-                            execvp(pargv[0], pargv);
-
-                        } 
-                        
-                        // main process
-                        else {
-
-                            close(child[i]->pipe_to_child[0]);
-                            close(child[i]->pipe_from_child[1]);
-
-                            // send current time to child
-                            child[i]->simulation_time_big_endian = 
-                                      htonl(*time);
-                            write(child[i]->pipe_to_child[1], &child[i]->
-                                  simulation_time_big_endian, 
-                                  sizeof(uint32_t));
-
-                            // get and validate response
-                            uint8_t response;
-                            read(child[i]->pipe_from_child[0], &response, 
-                                 sizeof(response));
-                            if (response != (*time & 0xFF)) {
-                                exit(EXIT_FAILURE);
-                            }
-                        }
-
-                        // print running message
-                        print_running_msg(*time, remain_time[i],
-                                           get_process_name(p[i]));
-                                      
-                    } 
-                    
-                    // continue run process
-                    else {
-                        send_cont_signal(child, time, i);
-                        print_running_msg(*time, remain_time[i],
-                                          get_process_name(p[i]));
-
-                    }
-
-                    // store previous process key info
-                    last_process = get_process_name(p[i]);
-                    last_process_index = i;
-
-                } 
-                
-                // same process run in another rr
-                else if (mem_allocated[i] && 
-                         strcmp(last_process, 
-                         get_process_name(p[i])) == 0) {
-
-                    send_cont_signal(child, time, i);
-                } 
-                
-                // reject process when it is not arrive
-                else if (!mem_allocated[i]) {
-                    *time = *time - q;
-                    remain_time[i] += q;
-                }
-                
-                // update current time
-                // update remain time for current process
-                *time = *time + q;
-                remain_time[i] -= q;
-
-                // process finish
-                if (remain_time[i] <= 0) {
-                    is_finished[i] = 1;       
-
-                    // print result
-                    print_result_msg(n, q, *time, p, is_finished, 
-                                     get_process_name(p[i]));
-
-                    // terminate child process
-                    child[i]->simulation_time_big_endian = htonl(*time);
-                    write(child[i]->pipe_to_child[1], 
-                         &child[i]->simulation_time_big_endian, 
-                          sizeof(uint32_t));
-                    kill(child[i]->pid, SIGTERM);
-
-                    // wait child to terminate
-                    int status;
-                    waitpid(child[i]->pid, &status, 0);
-
-                    // read 64-byte string from child 
-                    char sha[65];
-                    read(child[i]->pipe_from_child[0], sha, 64);
-                    sha[64] = '\0';
-
-                    // print sha
-                    printf("%d,FINISHED-PROCESS,process_name=%s,sha=%s\n", 
-                            *time, get_process_name(p[i]), 
-                            sha);
-
-                    // close pipelines
-                    close(child[i]->pipe_to_child[1]);
-                    close(child[i]->pipe_from_child[0]);
-                    child[i]->in_use = 0;
-
-                    // calc stats when one process finish
-                    *turnaround = *turnaround + 
-                                 (*time - get_arrival_time(p[i]));
-                    if ((double)(*time - get_arrival_time(p[i])) / 
-                                (get_service_time(p[i])) > *max_overhead) {
-                        *max_overhead = (double)
-                                        (*time - get_arrival_time(p[i])) / 
-                                                 get_service_time(p[i]);
-                    }
-                    *total_overhead = *total_overhead + 
-                                      (double)
-                                      (*time - get_arrival_time(p[i])) /
-                                               get_service_time(p[i]);
-                    
-                    // clear process memory block
-                    if (use_strategy) {
-                        clear_mem(memory, memstart[i], get_process_mem(p[i]));
-                        break;
-                    }
-                }
-            }
+
+// Clear hash ring of child and store its name and start into it
+static void start_ring(child_t *child, char *name, long long time) {
+    memset(child->ring, 0, sizeof(child->ring));
+    child->ring_index = 0;
+    child->name = name;
+    store_ring(child, (uint8_t *)name, strlen(name));
+    record_op(child, OP_START, time);
+}
+
+
+// Store handshake into a real process's ring when its digest is checked
+static void shadow_op(child_t *child, int op, long long time) {
+    if (child->check != NULL) record_op(child, op, time);
+}
+
+
+// Hash the pending group again, all lanes at once, and count those
+// differing from what their process reported
+static void check_hashes(hash_check_t *check) {
+    char expected[HASH_GROUP][65];
+    const uint8_t *bufs[HASH_GROUP];
+    for (int k = 0; k < check->pending; k++) {
+        bufs[k] = check->content[k];
+    }
+    sha256_hash_many(expected, bufs, check->pending, HASH_RING);
+    for (int k = 0; k < check->pending; k++) {
+        if (strcmp(expected[k], check->reported[k]) != 0) {
+            fprintf(stderr, "Hash mismatch for %s\n", check->name[k]);
+            check->mismatched++;
         }
+    }
+    check->checked += check->pending;
+    check->pending = 0;
+}
+
+
+// Hold digest a real process reported until its group is full
+static void add_hash(hash_check_t *check, child_t *child, char *sha) {
+    int k = check->pending++;
+    memcpy(check->content[k], child->ring, HASH_RING);
+    memcpy(check->reported[k], sha, 65);
+    check->name[k] = child->name;
+    if (check->pending == HASH_GROUP) check_hashes(check);
+}
+
+
+// Check digests still held and print how many differed
+void print_hash_summary(FILE *out, hash_check_t *check) {
+    if (check->pending > 0) check_hashes(check);
+    fprintf(out, "Hashes checked %d mismatched %d\n", check->checked, 
+            check->mismatched);
+}
 
-        // check if all processes are complete
-        int finished_count = 0;
-        for (int i = 0; i < n; i++) {
-            if (is_finished[i] == 1) finished_count++;
+
+// Start simulated process, its ring starting with its name
+static void start_simulated(child_t *child, char *name, long long time) {
+    child->in_use = 1;
+    child->pending = 0;
+    start_ring(child, name, time);
+}
+
+
+// Run simulated process i for the next span of quanta as
+// dispatch_process does, recording handshakes straight into its ring
+// quanta are never held back, so no span is pending on a switch
+void dispatch_simulated(run_t *run, int i, int span) {
+
+    child_t **child = run->child;
+    long long q = run->opts->quantum;
+    long long time = *run->time;
+
+    int first = 0;
+    if (run->last != i) {
+        if (run->last != -1 && child[run->last]->in_use) {
+            record_op(child[run->last], OP_STOP, time);
         }
-        all_finished = finished_count == n ? 1 : 0;
+        if (child[i]->in_use == 0) {
+            start_simulated(child[i], get_process_name(run->p[i]), time);
+            record_start(run->stats, get_arrival_time(run->p[i]), 
+                         get_process_mem(run->p[i]), time);
+            run->live++;
+        } else {
+            record_op(child[i], OP_CONTINUE, time);
+        }
+        print_running_msg(run->out, time, run->remain_time[i], 
+                          get_process_name(run->p[i]));
+        run->last = i;
+        first = 1;
+    }
+    for (int k = first; k < span; k++) {
+        record_op(child[i], OP_CONTINUE, time + (long long)k * q);
+    }
+}
+
+
+// Finish process i, reporting and releasing its memory
+void finish_process(run_t *run, int i) {
+
+    process_t *p = run->p[i];
+    long long time = *run->time;
+    run->is_finished[i] = 1;
+
+    // print result
+    print_result_msg(run->out, time, get_process_name(p), 
+                     check_proc_remaining(run, time));
+
+    // terminate child process and print sha
+    char sha[65];
+    terminate_child(run->child[i], time, sha);
+    run->live--;
+    fprintf(run->out, "%lld,FINISHED-PROCESS,process_name=%s,sha=%s\n", 
+            time, get_process_name(p), sha);
+
+    // calc stats when one process finish
+    record_finish(run->stats, get_arrival_time(p), get_service_time(p), 
+                  get_process_mem(p), time);
+
+    // stream completion back to whoever submitted it
+    if (run->server != NULL) {
+        char event[MAX_SUBMIT_LINE];
+        int length = snprintf(event, sizeof(event), 
+                              "%lld,FINISHED,process_name=%s,"
+                              "turnaround=%lld\n", 
+                              time, get_process_name(p), 
+                              time - get_arrival_time(p));
+        send_event(run->server, event, length);
+        run->free_slots[run->num_free++] = i;
+    }
 
+    // clear process memory block
+    if (run->pages != NULL) free_pages(run->pages, i);
+    if (run->memory != NULL) {
+        sample_mem(run->memory, time);
+        clear_mem(run->memory, run->memstart[i], get_process_mem(p));
+        if (run->opts->mem_sample) {
+            print_mem_msg(run->out, time, run->memory);
+        }
     }
+}
+
 
-    // free child memory
+// Compact suspended processes' memory so process k fits
+// only done when the copy, which every other unfinished process also
+// waits out, costs less in turnaround than k would otherwise wait
+int try_compaction(run_t *run, int k) {
+
+    process_t **p = run->p;
+    int n = run->slots;
+    int *memstart = run->memstart;
+    mem_table_t *memory = run->memory;
+    arena_t *scratch = run->scratch;
+    long long q = run->opts->quantum;
+    int need = get_process_mem(p[k]);
+    if (MAX_MEMORY - get_mem_live(memory) < need) return 0;
+
+    // gather live allocations, keeping running process in place
+    reset_arena(scratch);
+    int count = 0;
+    int *owner = arena_alloc(scratch, n * sizeof(int));
+    int *starts = arena_alloc(scratch, n * sizeof(int));
+    int *sizes = arena_alloc(scratch, n * sizeof(int));
+    int *pinned = arena_alloc(scratch, n * sizeof(int));
+    long long earliest_free = LLONG_MAX;
     for (int i = 0; i < n; i++) {
-        free(child[i]);
+        if (run->mem_allocated[i] && !run->is_finished[i] && 
+            memstart[i] != -1) {
+            owner[count] = i;
+            starts[count] = memstart[i];
+            sizes[count] = get_process_mem(p[i]);
+            pinned[count] = i == run->last;
+            if (run->remain_time[i] < earliest_free) {
+                earliest_free = run->remain_time[i];
+            }
+            count++;
+        }
     }
-    free(child);
 
-    // free memory block's mem
-    if (use_strategy) {
-        free_mem(memory);
+    // k waits at least until some holder finishes, while the copy
+    // holds back the holders and the rest still waiting
+    long long others = count + get_num_waiting(run->queue) - 1;
+
+    // check relocation would both fit process and pay off
+    int moved;
+    if (compact_mem(memory, count, starts, sizes, pinned, 0, 
+                    &moved) < need) {
+        return 0;
     }
+    long long cost = (long long)ceil(moved * run->opts->compact_cost);
+    if (cost % q != 0) cost += q - cost % q;
+    if (cost * others >= earliest_free) return 0;
+
+    // relocate and account for time spent copying
+    compact_mem(memory, count, starts, sizes, pinned, 1, &moved);
+    for (int c = 0; c < count; c++) {
+        int i = owner[c];
+        if (starts[c] != memstart[i]) {
+            print_relocated_msg(run->out, *run->time, get_process_name(p[i]), 
+                                memstart[i], starts[c]);
+            memstart[i] = starts[c];
+        }
+    }
+    *run->time = *run->time + cost;
 
+    return 1;
 }
 
 
@@ -584,63 +966,303 @@ int compare_service_time(const void *a, const void *b) {
 
 
 // Print process is running message
-void print_running_msg(int time, int remain_time, char *name) {
-    printf("%d,RUNNING,process_name=%s,remaining_time=%d\n", 
+void print_running_msg(FILE *out, long long time, long long remain_time, 
+                       char *name) {
+    fprintf(out, "%lld,RUNNING,process_name=%s,remaining_time=%lld\n", 
             time, name, remain_time);
 }
 
 
 // Print result given process running
-void print_result_msg(int n, int q, int time, 
-                      process_t **p, int *is_finished, char *name) {
-    printf("%d,FINISHED,process_name=%s,proc_remaining=%d\n", 
-            time, name, 
-            check_proc_remaining(n, q, time, p, is_finished));
+void print_result_msg(FILE *out, long long time, char *name, 
+                      int remaining) {
+    fprintf(out, "%lld,FINISHED,process_name=%s,proc_remaining=%d\n", 
+            time, name, remaining);
+}
+
+
+// Print pages loaded for or evicted from a process
+void print_page_msg(FILE *out, long long time, char *event, char *name, 
+                    int pages) {
+    fprintf(out, "%lld,%s,process_name=%s,pages=%d\n", time, event, name, 
+            pages);
+}
+
+
+// Print paging counters of the run
+void print_page_summary(FILE *out, page_table_t *pages) {
+    fprintf(out, "Paging faults %lld\nPages loaded %lld evicted %lld\n"
+            "Paging time %lld\n", get_page_faults(pages), 
+            get_pages_loaded(pages), get_pages_evicted(pages), 
+            get_page_time(pages));
+}
+
+
+// Print how closely paced deadlines were met, in microseconds
+void print_pace_summary(FILE *out, pacer_t *pacer) {
+    fprintf(out, "Pacing ticks %lld missed %lld\n"
+            "Pacing drift %.2lf %.2lf\nPacing jitter %.2lf\n", 
+            get_pace_ticks(pacer), get_pace_missed(pacer), 
+            get_pace_drift(pacer), get_pace_max_drift(pacer), 
+            get_pace_jitter(pacer));
+}
+
+
+// Print quantum adaptive round robin moved to, and the depth behind it
+void print_quantum_msg(FILE *out, long long time, long long quantum, 
+                       int ready) {
+    fprintf(out, "%lld,QUANTUM,quantum=%lld,ready=%d\n", time, quantum, 
+            ready);
 }
 
 
 // Print a process is ready message
-void print_ready_msg(int time, char *name, int memstart) {
-    printf("%d,READY,process_name=%s,assigned_at=%d\n", 
+void print_ready_msg(FILE *out, long long time, char *name, int memstart) {
+    fprintf(out, "%lld,READY,process_name=%s,assigned_at=%d\n", 
             time, name, memstart);
 }
 
 
+// Print a process memory has been moved message
+void print_relocated_msg(FILE *out, long long time, char *name, 
+                         int from, int to) {
+    fprintf(out, "%lld,RELOCATED,process_name=%s,from=%d,to=%d\n", 
+            time, name, from, to);
+}
+
+
+// Print a snapshot of memory statistics
+void print_mem_msg(FILE *out, long long time, mem_table_t *memory) {
+    fprintf(out, "%lld,MEMORY,live=%d,holes=%d,largest_hole=%d,"
+           "fragmentation=%.2lf,failed=%d\n", 
+            time, get_mem_live(memory), get_mem_holes(memory), 
+            get_mem_largest_hole(memory), get_mem_fragmentation(memory), 
+            get_mem_failed(memory));
+}
+
+
+// Print memory statistics over the whole run
+void print_mem_summary(FILE *out, mem_table_t *memory) {
+    fprintf(out, "Memory usage %.2lf %d\nMemory holes %d\n"
+           "Memory fragmentation %.2lf %.2lf\nMemory failed %d %d\n", 
+            round(get_mem_utilisation(memory) * 100) / 100, 
+            get_mem_peak(memory), get_mem_max_holes(memory), 
+            round(get_mem_max_fragmentation(memory) * 100) / 100, 
+            round(get_mem_avg_fragmentation(memory) * 100) / 100, 
+            get_mem_failed(memory), get_mem_relocated(memory));
+}
+
+
 // Check remaining processes in ready
-int check_proc_remaining(int n, int q, int time, 
-                         process_t **p, int *is_finished) {        
+int check_proc_remaining(run_t *run, long long time) {
 
-    // check reamining ready process       
-    int remain = 0;
-    for (int i = 0; i < n; i++) {
-        if (is_finished[i] == 0) {
-
-            // process may ready only when it arrives ahead
-            if (get_arrival_time(p[i]) < time) {
-
-                // process ready when meet current or previous quantum
-                if ((get_arrival_time(p[i]) % q == 0) || 
-                    (get_arrival_time(p[i]) / q == time / q - 1 && 
-                     time % q != 0) ||
-                    (get_arrival_time(p[i]) / q < time / q - 1)) {
-                    remain++;
-                }
-            }
-        }
+    // process ready when meet current or previous quantum
+    long long q = run->opts->quantum;
+    long long limit = time % q != 0 ? time / q : time / q - 1;
+    return count_remaining(run->arrival, run->slot, run->aligned, 
+                           run->is_finished, run->slots, time, limit);
+}
+
+// Fill in process exec and its mode flags, pinning forked child first
+// return number of arguments filled
+static int child_args(child_t *child, char **pargv) {
+    if (child->num_cpus > 0) pin_cpus(child->cpus, child->num_cpus);
+    int argc = 0;
+    pargv[argc++] = "./process";
+    if (child->fast) pargv[argc++] = "--fast";
+    if (child->spin) pargv[argc++] = "--spin";
+    return argc;
+}
+
+
+// Start process sharing a ring, handing it the memory file by number
+static void start_shared_child(child_t *child, char *name, 
+                               long long time) {
+
+    int fd;
+    child->shared_ring = create_ring(&fd);
+    child->in_use = 1;
+    child->pending = 0;
+    child->stopped = 0;
+    child->pid = fork();
+
+    // child process keeps the memory file open across exec
+    if (child->pid == 0) {
+        fcntl(fd, F_SETFD, 0);
+        char fd_arg[16];
+        snprintf(fd_arg, sizeof(fd_arg), "%d", fd);
+        char *pargv[8];
+        int argc = child_args(child, pargv);
+        pargv[argc++] = "--ring";
+        pargv[argc++] = fd_arg;
+        pargv[argc++] = name;
+        pargv[argc] = NULL;
+        execvp(pargv[0], pargv);
+    }
+    close(fd);
+
+    // wait for start to be taken and validate response
+    push_ring(child->shared_ring, OP_START, time, 0, 1);
+    if (drain_ring(child->shared_ring) != (time & 0xFF)) exit(EXIT_FAILURE);
+}
+
+
+// Write time to process through its pipe, as wire.h lays it out
+static void send_time(child_t *child, long long time) {
+    uint8_t buf[WIRE_MAX_TIME];
+    write(child->pipe_to_child[1], buf, put_time(buf, time));
+}
+
+
+// Fork child running process exec and hand it start time
+void start_child(child_t *child, char *name, long long time) {
+
+    if (child->simulated) {
+        start_simulated(child, name, time);
+        return;
+    }
+
+    if (child->check != NULL) start_ring(child, name, time);
+    if (child->shared) {
+        start_shared_child(child, name, time);
+        return;
+    }
+
+    // initialize pipeline, kept from other processes' execs
+    pipe2(child->pipe_to_child, O_CLOEXEC);
+    pipe2(child->pipe_from_child, O_CLOEXEC);
+
+    // create child process
+    child->in_use = 1;
+    child->pending = 0;
+    child->pid = fork();
+
+    // child process
+    if (child->pid == 0) {
+
+        // open pipeline
+        dup2(child->pipe_to_child[0], STDIN_FILENO);
+        dup2(child->pipe_from_child[1], STDOUT_FILENO);
+        close(child->pipe_to_child[1]);
+        close(child->pipe_from_child[0]);
+
+        // run prebuilt process exec
+        char *pargv[8];
+        int argc = child_args(child, pargv);
+        pargv[argc++] = name;
+        pargv[argc] = NULL;
+        execvp(pargv[0], pargv);
+
+    }
+
+    // main process
+    close(child->pipe_to_child[0]);
+    close(child->pipe_from_child[1]);
+
+    // send current time to child
+    send_time(child, time);
+
+    // get and validate response
+    uint8_t response;
+    read(child->pipe_from_child[0], &response, sizeof(response));
+    if (response != (time & 0xFF)) exit(EXIT_FAILURE);
+}
+
+
+// Suspend child while another process runs
+void suspend_child(child_t *child, long long time) {
+
+    flush_cont_signal(child);
+    if (child->simulated) {
+        record_op(child, OP_STOP, time);
+        return;
+    }
+    shadow_op(child, OP_STOP, time);
+
+    // process stops itself once it takes the record
+    if (child->shared) {
+        push_ring(child->shared_ring, OP_STOP, time, 0, 1);
+        child->stopped = 1;
+    } else {
+
+        // send time to process
+        send_time(child, time);
+
+        // send process to suspend
+        kill(child->pid, SIGTSTP);
+    }
+
+    // wait till process is been suspended
+    int wstatus = 0;
+    waitpid(child->pid, &wstatus, WUNTRACED);
+    while (!WIFSTOPPED(wstatus)) {
+        waitpid(child->pid, &wstatus, WUNTRACED);
+    }
+}
+
+
+// Terminate child and read back its 64-byte sha
+void terminate_child(child_t *child, long long time, char *sha) {
+
+    // terminate child process
+    flush_cont_signal(child);
+    if (child->simulated) {
+        record_op(child, OP_TERM, time);
+        sha256_hash(sha, child->ring, HASH_RING);
+        child->in_use = 0;
+        return;
     }
+    shadow_op(child, OP_TERM, time);
 
-    return remain;
+    // process leaves its hash in the ring as it exits
+    if (child->shared) {
+        push_ring(child->shared_ring, OP_TERM, time, 0, 1);
+        int status;
+        waitpid(child->pid, &status, 0);
+        get_ring_hash(child->shared_ring, sha);
+        free_ring(child->shared_ring);
+        child->in_use = 0;
+        if (child->check != NULL) add_hash(child->check, child, sha);
+        return;
+    }
+    send_time(child, time);
+    kill(child->pid, SIGTERM);
+
+    // wait child to terminate
+    int status;
+    waitpid(child->pid, &status, 0);
+
+    // read 64-byte string from child 
+    read(child->pipe_from_child[0], sha, 64);
+    sha[64] = '\0';
+
+    // close pipelines
+    close(child->pipe_to_child[1]);
+    close(child->pipe_from_child[0]);
+    child->in_use = 0;
+    if (child->check != NULL) add_hash(child->check, child, sha);
 }
 
 
 // Send a continue signal to process
-void send_cont_signal(child_t **child, int *time, int i) {
+void send_cont_signal(child_t **child, long long *time, int i) {
 
-    child[i]->simulation_time_big_endian = htonl(*time);
+    if (child[i]->simulated) {
+        record_op(child[i], OP_CONTINUE, *time);
+        return;
+    }
+    shadow_op(child[i], OP_CONTINUE, *time);
+
+    // running process needs no signal, nor a wait for its response
+    if (child[i]->shared) {
+        push_ring(child[i]->shared_ring, OP_CONTINUE, *time, 0, 1);
+        if (child[i]->stopped) kill(child[i]->pid, SIGCONT);
+        child[i]->stopped = 0;
+        return;
+    }
 
     // send time for child to continue
-    write(child[i]->pipe_to_child[1], &child[i]->simulation_time_big_endian, 
-          sizeof(uint32_t));
+    send_time(child[i], *time);
     kill(child[i]->pid, SIGCONT);
 
     // get and validate response
@@ -649,4 +1271,106 @@ void send_cont_signal(child_t **child, int *time, int i) {
 
     // exit if mismatched
     if (response != (*time & 0xFF)) exit(EXIT_FAILURE);
+}
+
+
+// Hold back continues of a process which is still running
+// consecutive quanta are sent later as a single span
+void defer_cont_signal(child_t *child, long long time, long long q, 
+                       int count) {
+
+    // span only covers back to back quanta, as many as a count holds
+    if (child->pending > 0 && 
+        (time != child->pending_from + 
+                 (long long)child->pending * child->pending_step || 
+         child->pending > INT_MAX - count)) {
+        flush_cont_signal(child);
+    }
+
+    if (child->pending == 0) {
+        child->pending_from = time;
+        child->pending_step = q;
+    }
+    child->pending += count;
+}
+
+
+// Send held back quanta to process as one span of continues
+void flush_cont_signal(child_t *child) {
+
+    if (child->pending == 0) return;
+
+    // simulated process stores every quantum of the span, as does a
+    // real one whose digest is checked
+    if (child->simulated || child->check != NULL) {
+        for (int k = 0; k < child->pending; k++) {
+            record_op(child, OP_CONTINUE, 
+                      child->pending_from + 
+                      (long long)k * child->pending_step);
+        }
+    }
+    if (child->simulated) {
+        child->pending = 0;
+        return;
+    }
+
+    if (child->shared) {
+        push_ring(child->shared_ring, OP_CONTINUE, child->pending_from, 
+                  child->pending_step, child->pending);
+        child->pending = 0;
+        return;
+    }
+
+    // first time, step between quanta and number of quanta
+    uint8_t span[WIRE_MAX_TIME + 2 * sizeof(uint32_t)];
+    size_t len = put_time(span, child->pending_from);
+    uint32_t words[2] = {htonl(child->pending_step), htonl(child->pending)};
+    memcpy(span + len, words, sizeof(words));
+    write(child->pipe_to_child[1], span, len + sizeof(words));
+    kill(child->pid, SIGUSR1);
+
+    // child acknowledges time of last quantum
+    long long last = child->pending_from + 
+                     (long long)(child->pending - 1) * child->pending_step;
+    uint8_t response;
+    read(child->pipe_from_child[0], &response, sizeof(response));
+    if (response != (last & 0xFF)) exit(EXIT_FAILURE);
+
+    child->pending = 0;
+}
+
+
+// XOR bytes into simulated process's hash ring, as process.c does
+void store_ring(child_t *child, uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        child->ring_index = (child->ring_index + i) % HASH_RING;
+        child->ring[child->ring_index] ^= buf[i];
+    }
+}
+
+
+// Store one handshake of op and time as sent on the wire into the ring
+void record_op(child_t *child, int op, long long time) {
+    uint8_t buf[1 + WIRE_MAX_TIME];
+    buf[0] = op;
+    store_ring(child, buf, 1 + put_time(buf + 1, time));
+}
+
+
+// Write simulated process state, flushing any held back quanta first
+void save_child(child_t *child, FILE *file) {
+    flush_cont_signal(child);
+    fwrite(&child->in_use, sizeof(int), 1, file);
+    fwrite(child->ring, 1, HASH_RING, file);
+    fwrite(&child->ring_index, sizeof(size_t), 1, file);
+}
+
+
+// Read simulated process state written by save_child
+void load_child(child_t *child, FILE *file) {
+    memset(child->ring, 0, sizeof(child->ring));
+    fread(&child->in_use, sizeof(int), 1, file);
+    fread(child->ring, 1, HASH_RING, file);
+    fread(&child->ring_index, sizeof(size_t), 1, file);
+    child->pending = 0;
 }
\ No newline at end of file
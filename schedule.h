@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/wait.h>
 #include <sys/types.h>
@@ -14,36 +15,254 @@
 
 #include "data.h"
 #include "memory.h"
+#include "queue.h"
+#include "arena.h"
+#include "ready.h"
+#include "sha256.h"
+#include "ring.h"
+#include "stats.h"
+#include "paging.h"
+#include "pace.h"
+#include "affinity.h"
+#include "server.h"
+#include "metrics.h"
+#include "scan.h"
+#include "wire.h"
 
 #define IMPLEMENTS_REAL_PROCESS
 
+#define MAX_LEVELS 8
+
 typedef struct child child_t;
+typedef struct hash_check hash_check_t;
+typedef struct run run_t;
+
+typedef struct options {
+    char *scheduler;
+    char *mem_strategy;
+    long long quantum;
+    int coalesce;
+    int simulate;
+    int fast_process;
+    int shm_transport;
+    int verify_hashes;
+    int pace;
+    int *child_cpus;
+    int num_child_cpus;
+    int spread;
+    char *daemon;
+    int max_jobs;
+    char *metrics;
+    char *checkpoint;
+    long long checkpoint_every;
+    char *resume;
+    int mem_stats;
+    int mem_sample;
+    int stats;
+    int compact;
+    double compact_cost;
+    long long fault_cost;
+    long long evict_cost;
+    int levels;
+    int level_quanta[MAX_LEVELS];
+    long long boost;
+    int slice_min;
+    int slice_max;
+} options_t;
+
+// Totals of one run, before rounding for output
+typedef struct run_stats {
+    int processes;
+    long long turnaround;
+    double max_overhead;
+    double total_overhead;
+    long long makespan;
+} run_stats_t;
+
+struct run {
+
+    // processes given so far and the slots they took, fewer once a
+    // daemon hands finished processes' slots to later ones
+    process_t **p;
+    int n;
+    int slots;
+    int capacity;
+    options_t *opts;
+    arena_t *arena;
+    arena_t *scratch;
+    FILE *out;
+    long long *time;
+    int *is_finished;
+    long long *remain_time;
+
+    // memory state, table is NULL with infinite memory
+    // and with paged memory, where pages are kept instead
+    mem_table_t *memory;
+    page_table_t *pages;
+    wait_queue_t *queue;
+    int *mem_allocated;
+    int *memstart;
+    long long *arrival;
+    int *size;
+    int *admitted;
+
+    // arrival quantum and whether arrival falls on a quantum boundary
+    long long *slot;
+    int *aligned;
+    long long admitted_until;
+
+    // arrival order, fed to policies and used to skip idle time
+    int *order;
+    int fed;
+    int idle;
+
+    // children, how many are alive and which one ran last
+    child_t **child;
+    int live;
+    int last;
+
+    // policy state, current is -1 when nothing holds the cpu
+    // backfilled counts those queued past a blocked head job
+    int current;
+    int cursor;
+    int seq;
+    int finished;
+    int backfilled;
+    ready_heap_t *heap;
+    ready_fifo_t *fifo;
+    ready_fifo_t **levels;
+    int *level;
+    int *used;
+    long long next_boost;
+    long long next_checkpoint;
+
+    // adaptive round robin slice in quanta, how much of it is used,
+    // processes holding memory and how many quanta recent arrivals need
+    int slice;
+    int slice_used;
+    int slice_ready;
+    int *service_quanta;
+    int service_count;
+
+    // wall clock pacing, NULL when time is abstract
+    pacer_t *pacer;
+
+    // live metrics file, NULL when not exported
+    metrics_t *metrics;
+    long long events;
+
+    // socket processes are submitted on, NULL when all come from a trace
+    // and slots of finished processes it can reuse
+    server_t *server;
+    int *free_slots;
+    int num_free;
+
+    // digests of real processes checked after the fact, NULL if not
+    hash_check_t *hash_check;
+
+    // statistics
+    stats_t *stats;
+};
+
+// Scheduler hooks driven by the shared run engine, any may be NULL
+// but pick_next, which returns -1 when nothing is ready
+// without contended a running process keeps the cpu until an event
+// without next_event the policy has no timed events of its own
+// the policy's own loops with its hooks built in take plain runs,
+// see engine.h
+typedef struct sched_ops {
+    char *name;
+    int (*compare)(const void *a, const void *b);
+    void (*init)(run_t *run);
+    void (*admit)(run_t *run);
+    int (*pick_next)(run_t *run);
+    int (*contended)(run_t *run, int i);
+    long long (*next_event)(run_t *run);
+    void (*on_quantum_end)(run_t *run, int i, int quanta);
+    void (*on_finish)(run_t *run, int i);
+    void (*real_engine)(run_t *run);
+    void (*simulated_engine)(run_t *run);
+} sched_ops_t;
+
+void start_scheduling(process_t **lines, int num, options_t *opts, 
+                      arena_t *arena, FILE *out, run_stats_t *stats);
+
+run_t *create_run(process_t **p, int n, int capacity, options_t *opts, 
+                  arena_t *arena, FILE *out, long long *time, 
+                  int *is_finished, mem_table_t *memory);
+
+void run_engine(run_t *run, sched_ops_t *ops);
+
+int can_hold(run_t *run, int size);
+
+int admit_waiting(run_t *run);
 
-void start_scheduling(process_t **lines, char *scheduler, 
-                      int num, int quantum, char *mem_strategy);
+int get_quanta_left(run_t *run, int i);
 
-void do_sjf(process_t **p, int num, int q, int *time, 
-            int *is_finished, char *mem_strategy, int *turnaround, 
-            double *max_overhead, double *total_overhead);
+int cap_span(run_t *run, int span, long long event);
 
-void do_rr(process_t **p, int num, int q, int *time, 
-           int *is_finished, char *mem_strategy, int *turnaround, 
-           double *max_overhead, double *total_overhead);
+void skip_to_arrival(run_t *run);
+
+void dispatch_process(run_t *run, int i, int span);
+
+void dispatch_simulated(run_t *run, int i, int span);
+
+void finish_process(run_t *run, int i);
+
+int try_compaction(run_t *run, int k);
 
 int compare_arrival_time(const void *a, const void *b);
 
 int compare_service_time(const void *a, const void *b);
 
-void print_running_msg(int time, int remain_time, char *name);
+void print_running_msg(FILE *out, long long time, long long remain_time, 
+                       char *name);
+
+void print_result_msg(FILE *out, long long time, char *name, 
+                      int remaining);
+
+void print_page_msg(FILE *out, long long time, char *event, char *name, 
+                    int pages);
+
+void print_page_summary(FILE *out, page_table_t *pages);
+
+void print_pace_summary(FILE *out, pacer_t *pacer);
+
+void print_hash_summary(FILE *out, hash_check_t *check);
+
+void print_quantum_msg(FILE *out, long long time, long long quantum, 
+                       int ready);
+
+void print_ready_msg(FILE *out, long long time, char *name, int memstart);
+
+void print_relocated_msg(FILE *out, long long time, char *name, 
+                         int from, int to);
+
+void print_mem_msg(FILE *out, long long time, mem_table_t *memory);
+
+void print_mem_summary(FILE *out, mem_table_t *memory);
+
+int check_proc_remaining(run_t *run, long long time);
+
+void start_child(child_t *child, char *name, long long time);
+
+void suspend_child(child_t *child, long long time);
+
+void terminate_child(child_t *child, long long time, char *sha);
+
+void send_cont_signal(child_t **child, long long *time, int i);
+
+void defer_cont_signal(child_t *child, long long time, long long q, 
+                       int count);
+
+void flush_cont_signal(child_t *child);
 
-void print_result_msg(int n, int q, int time, 
-                      process_t **p, int *is_finished, char *name);
+void store_ring(child_t *child, uint8_t *buf, size_t len);
 
-void print_ready_msg(int time, char *name, int memstart);
+void record_op(child_t *child, int op, long long time);
 
-int check_proc_remaining(int n, int q, int time, 
-                         process_t **p, int *is_finished);
+void save_child(child_t *child, FILE *file);
 
-void send_cont_signal(child_t **child, int *time, int i);
+void load_child(child_t *child, FILE *file);
 
 #endif
\ No newline at end of file
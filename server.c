@@ -0,0 +1,347 @@
+#define _GNU_SOURCE
+#include "server.h"
+
+struct server
+{
+    char *path;
+    int listen_fd;
+    int client_fd;
+    int wake[2];
+    pthread_t thread;
+
+    // submissions filled by the io thread, and the batch taken last
+    // which the scheduler reads until it takes the next
+    pthread_mutex_t lock;
+    pthread_cond_t arrived;
+    submission_t *inbox;
+    int inbox_count;
+    int inbox_size;
+    submission_t *taken;
+    int taken_size;
+    int ended;
+    int closing;
+
+    // events waiting for the client, and those being written out
+    char *outbox;
+    size_t outbox_length;
+    size_t outbox_size;
+    char *sending;
+    size_t sending_length;
+    size_t sending_size;
+    size_t sent;
+
+    // partial line left over from the last read
+    char line[MAX_SUBMIT_LINE];
+    size_t line_length;
+};
+
+
+// Wake io thread out of poll, a full pipe already wakes it
+static void wake_thread(server_t *server) {
+    char c = 0;
+    if (write(server->wake[1], &c, 1) == -1 && errno != EAGAIN) {
+        perror("write");
+    }
+}
+
+
+// Append bytes to a growing buffer
+static void append_bytes(char **buf, size_t *length, size_t *size, 
+                         char *data, size_t count) {
+    if (*length + count > *size) {
+        while (*length + count > *size) {
+            *size = *size > 0 ? *size * 2 : SERVER_CHUNK;
+        }
+        *buf = realloc(*buf, *size);
+    }
+    memcpy(*buf + *length, data, count);
+    *length += count;
+}
+
+
+// Parse "name service memory [priority]" into job
+// return 0 when line is malformed
+static int parse_submission(char *line, submission_t *job) {
+    char name[MAX_SUBMIT_LINE];
+    job->priority = 0;
+    if (sscanf(line, "%s %lld %d %d", name, &job->service, &job->memory, 
+               &job->priority) < 3 || strlen(name) >= MAX_PROCESS_NAME) {
+        return 0;
+    }
+    strcpy(job->name, name);
+    return 1;
+}
+
+
+// Split bytes read into lines, parsing complete ones into batch
+// return number of submissions parsed
+static int read_lines(server_t *server, char *buf, size_t length, 
+                      submission_t *batch) {
+
+    int count = 0;
+    for (size_t k = 0; k < length; k++) {
+        if (buf[k] != '\n') {
+            if (server->line_length < MAX_SUBMIT_LINE - 1) {
+                server->line[server->line_length++] = buf[k];
+            }
+            continue;
+        }
+        server->line[server->line_length] = '\0';
+        server->line_length = 0;
+
+        // client is done submitting
+        if (strcmp(server->line, "END") == 0) {
+            pthread_mutex_lock(&server->lock);
+            server->ended = 1;
+            pthread_mutex_unlock(&server->lock);
+            continue;
+        }
+        if (server->line[0] == '\0') continue;
+
+        // tell client which line was not taken
+        if (!parse_submission(server->line, &batch[count])) {
+            char event[MAX_SUBMIT_LINE + 16];
+            int n = snprintf(event, sizeof(event), "ERROR,line=%s\n", 
+                             server->line);
+            pthread_mutex_lock(&server->lock);
+            append_bytes(&server->outbox, &server->outbox_length, 
+                         &server->outbox_size, event, n);
+            pthread_mutex_unlock(&server->lock);
+            continue;
+        }
+        count++;
+    }
+    return count;
+}
+
+
+// Hand parsed batch to the scheduler in one go
+static void post_batch(server_t *server, submission_t *batch, int count) {
+    pthread_mutex_lock(&server->lock);
+    if (server->inbox_count + count > server->inbox_size) {
+        while (server->inbox_count + count > server->inbox_size) {
+            server->inbox_size = server->inbox_size > 0 ? 
+                                 server->inbox_size * 2 : SERVER_CHUNK;
+        }
+        server->inbox = realloc(server->inbox, 
+                                server->inbox_size * sizeof(submission_t));
+    }
+    memcpy(server->inbox + server->inbox_count, batch, 
+           count * sizeof(submission_t));
+    server->inbox_count += count;
+    if (server->inbox_count > 0 || server->ended) {
+        pthread_cond_signal(&server->arrived);
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+
+// Drop client, anything unsent to it is lost
+static void drop_client(server_t *server) {
+    close(server->client_fd);
+    server->client_fd = -1;
+    server->line_length = 0;
+}
+
+
+// Move submissions in and events out until closed
+// only this thread touches the sockets
+static void *serve(void *arg) {
+
+    server_t *server = arg;
+    char buf[SERVER_CHUNK];
+
+    // shortest line is a name and two numbers
+    submission_t *batch = malloc(SERVER_CHUNK / 6 * sizeof(submission_t));
+
+    while (1) {
+
+        // take events queued so far once the last lot is written
+        pthread_mutex_lock(&server->lock);
+        if (server->sent == server->sending_length && 
+            server->outbox_length > 0) {
+            char *temp = server->sending;
+            size_t size = server->sending_size;
+            server->sending = server->outbox;
+            server->sending_size = server->outbox_size;
+            server->sending_length = server->outbox_length;
+            server->outbox = temp;
+            server->outbox_size = size;
+            server->outbox_length = 0;
+            server->sent = 0;
+        }
+        int closing = server->closing;
+        pthread_mutex_unlock(&server->lock);
+
+        // events are only kept for a connected client
+        if (server->client_fd == -1) server->sent = server->sending_length;
+        int pending = server->sent < server->sending_length;
+        if (closing && !pending) break;
+
+        // wait on scheduler, and on new client or the one connected
+        struct pollfd fds[2];
+        fds[0].fd = server->wake[0];
+        fds[0].events = POLLIN;
+        if (server->client_fd == -1) {
+            fds[1].fd = server->listen_fd;
+            fds[1].events = POLLIN;
+        } else {
+            fds[1].fd = server->client_fd;
+            fds[1].events = POLLIN | (pending ? POLLOUT : 0);
+        }
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            while (read(server->wake[0], buf, sizeof(buf)) > 0);
+        }
+
+        // one client at a time
+        if (server->client_fd == -1) {
+            if (fds[1].revents & POLLIN) {
+                server->client_fd = accept4(server->listen_fd, NULL, NULL, 
+                                            SOCK_CLOEXEC);
+                if (server->client_fd != -1) {
+                    fcntl(server->client_fd, F_SETFL, O_NONBLOCK);
+                }
+            }
+            continue;
+        }
+
+        // write as many events as the socket takes
+        if (fds[1].revents & POLLOUT) {
+            ssize_t n = send(server->client_fd, 
+                             server->sending + server->sent, 
+                             server->sending_length - server->sent, 
+                             MSG_NOSIGNAL);
+            if (n > 0) {
+                server->sent += n;
+            } else if (n == -1 && errno != EAGAIN) {
+                drop_client(server);
+                continue;
+            }
+        }
+
+        // read submissions, a closed connection drops the client
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(server->client_fd, buf, sizeof(buf));
+            if (n > 0) {
+                int count = read_lines(server, buf, n, batch);
+                post_batch(server, batch, count);
+            } else if (n == 0 || errno != EAGAIN) {
+                drop_client(server);
+            }
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+
+// Listen on Unix socket at path, serving clients from its own thread
+server_t *open_server(char *path) {
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(addr.sun_path, path);
+
+    // a socket left by an earlier daemon is replaced
+    server_t *server = calloc(1, sizeof(server_t));
+    server->path = path;
+    server->client_fd = -1;
+    unlink(path);
+    // nothing opened here is passed on to exec'd processes
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->listen_fd == -1 || 
+        bind(server->listen_fd, (struct sockaddr *)&addr, 
+             sizeof(addr)) == -1 || 
+        listen(server->listen_fd, 16) == -1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    if (pipe2(server->wake, O_CLOEXEC) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(server->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server->wake[1], F_SETFL, O_NONBLOCK);
+
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->arrived, NULL);
+    pthread_create(&server->thread, NULL, serve, server);
+
+    return server;
+}
+
+
+// Take submissions posted since the last call, waiting for some if asked
+// jobs stay valid until the next call
+// return number taken, -1 once client has ended and none are left
+int take_submissions(server_t *server, submission_t **jobs, int wait) {
+
+    pthread_mutex_lock(&server->lock);
+    while (wait && server->inbox_count == 0 && !server->ended) {
+        pthread_cond_wait(&server->arrived, &server->lock);
+    }
+    int count = server->inbox_count;
+    if (count == 0 && server->ended) {
+        pthread_mutex_unlock(&server->lock);
+        return -1;
+    }
+
+    // swap buffers so the io thread fills the one read last time
+    submission_t *full = server->inbox;
+    int size = server->inbox_size;
+    server->inbox = server->taken;
+    server->inbox_size = server->taken_size;
+    server->inbox_count = 0;
+    server->taken = full;
+    server->taken_size = size;
+    pthread_mutex_unlock(&server->lock);
+
+    *jobs = server->taken;
+    return count;
+}
+
+
+// Queue event line for the client, waking io thread on the first one
+void send_event(server_t *server, char *event, int length) {
+    pthread_mutex_lock(&server->lock);
+    int was_empty = server->outbox_length == 0;
+    append_bytes(&server->outbox, &server->outbox_length, 
+                 &server->outbox_size, event, length);
+    pthread_mutex_unlock(&server->lock);
+    if (was_empty) wake_thread(server);
+}
+
+
+// Write out queued events, then stop serving and remove the socket
+void close_server(server_t *server) {
+
+    pthread_mutex_lock(&server->lock);
+    server->closing = 1;
+    pthread_mutex_unlock(&server->lock);
+    wake_thread(server);
+    pthread_join(server->thread, NULL);
+
+    if (server->client_fd != -1) close(server->client_fd);
+    close(server->listen_fd);
+    close(server->wake[0]);
+    close(server->wake[1]);
+    unlink(server->path);
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->arrived);
+    free(server->inbox);
+    free(server->taken);
+    free(server->outbox);
+    free(server->sending);
+    free(server);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "data.h"
+
+#define MAX_SUBMIT_LINE 128
+#define SERVER_CHUNK 65536
+
+typedef struct server server_t;
+
+// Process as the client gave it, arrival is when it is taken
+typedef struct submission {
+    char name[MAX_PROCESS_NAME];
+    long long service;
+    int memory;
+    int priority;
+} submission_t;
+
+server_t *open_server(char *path);
+
+int take_submissions(server_t *server, submission_t **jobs, int wait);
+
+void send_event(server_t *server, char *event, int length);
+
+void close_server(server_t *server);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,448 @@
+/*
+	sha256.c, SHA-256 used by process.c and the simulated processes
+	of allocate, split out of process.c
+	Blocks go through SHA-NI when the CPU has it, and sha256_hash_many
+	hashes 8 or 4 equal length messages at once with AVX2 or SSE2
+*/
+
+#include "sha256.h"
+
+/*****************************************************************************/
+/* SHA-256 Hashing, implemented by Steven Tang */
+/* Reference: RFC 6234 */
+
+/* SHA-256 Functions: RFC 6234, FIPS 180-3 section 4.1.2 */
+#define SHA_Ch(x, y, z) (((x) & (y)) ^ ((~(x)) & (z)))
+#define SHA_Maj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+#define SHA256_SHR(bits, word) ((word) >> (bits))
+#define SHA256_ROTL(bits, word)                                               \
+	(((word) << (bits)) | ((word) >> (32 - (bits))))
+#define SHA256_ROTR(bits, word)                                               \
+	(((word) >> (bits)) | ((word) << (32 - (bits))))
+
+#define SHA256_BSIG0(word)                                                    \
+	(SHA256_ROTR(2, word) ^ SHA256_ROTR(13, word) ^ SHA256_ROTR(22, word))
+#define SHA256_BSIG1(word)                                                    \
+	(SHA256_ROTR(6, word) ^ SHA256_ROTR(11, word) ^ SHA256_ROTR(25, word))
+#define SHA256_SSIG0(word)                                                    \
+	(SHA256_ROTR(7, word) ^ SHA256_ROTR(18, word) ^ SHA256_SHR(3, word))
+#define SHA256_SSIG1(word)                                                    \
+	(SHA256_ROTR(17, word) ^ SHA256_ROTR(19, word) ^ SHA256_SHR(10, word))
+
+/* SHA-256 Initial Hash Values: FIPS 180-3 section 5.3.3 */
+static uint32_t SHA256_H0[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372,
+								0xA54FF53A, 0x510E527F, 0x9B05688C,
+								0x1F83D9AB, 0x5BE0CD19};
+
+/* SHA-256 Constants: FIPS 180-3, section 4.2.2 */
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static void sha256_init(uint32_t hash[8]);
+static void sha256_compress(uint32_t message_block[16], uint32_t hash[8]);
+static void sha256_process(uint32_t message_block[16], uint32_t hash[8]);
+static void sha256_process_final(uint64_t nbyte, short leftover_bytes,
+								 uint32_t last_block[16], uint32_t hash[8]);
+static void uint32_array_to_hex_string(char* out, uint32_t* in,
+									   unsigned long length);
+#ifdef DEBUG
+static void print_uint32_array(uint32_t* arr, unsigned long length);
+#endif
+
+void sha256_hash(char hash_hexstring[65], const uint8_t* buf,
+				 const uint64_t nbyte) {
+	uint64_t i, num_blocks;
+	uint32_t hash[8], last_block[16];
+	short leftover_bytes;
+
+	/* each block is 512 bits, or 64 bytes */
+	/* last block needs to be processed differently for padding */
+	leftover_bytes = nbyte % 64;
+	num_blocks = leftover_bytes == 0 ? nbyte / 64 : nbyte / 64 + 1;
+
+#ifdef DEBUG
+	fprintf(stderr, "Blocks: %ld, Leftover bytes %d\n", num_blocks,
+			leftover_bytes);
+#endif
+
+	/* init */
+	sha256_init(hash);
+
+	/* process */
+	/* 64 = 512 bits per block / 8 bits for uint8_t */
+	for (i = 0; i < (leftover_bytes == 0 ? num_blocks : num_blocks - 1); i++) {
+		sha256_compress((uint32_t*)(buf + i * 64), hash);
+	}
+
+	/* final block */
+	memset(last_block, 0, 64);
+	if (leftover_bytes != 0) {
+		memcpy(last_block, buf + i * 64, leftover_bytes);
+	}
+	sha256_process_final(nbyte, leftover_bytes, last_block, hash);
+
+	/* print to buffer as hex string */
+	uint32_array_to_hex_string(hash_hexstring, hash, 8);
+}
+
+/* SHA-256 Initialization */
+/* https://www.rfc-editor.org/rfc/rfc6234#section-6.1 */
+static void sha256_init(uint32_t hash[8]) {
+	int i;
+	for (i = 0; i < 8; i++) {
+		hash[i] = SHA256_H0[i];
+	}
+}
+
+/* SHA-256 Processing */
+/* For each 32 * 16 = 512 block of bytes */
+/* https://www.rfc-editor.org/rfc/rfc6234#section-6.2 */
+static void sha256_process(uint32_t message_block[16], uint32_t hash[8]) {
+	int t;
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	uint32_t w[64];
+	uint8_t* message_ptr;
+
+	/* prepare message schedule */
+	for (t = 0; t < 64; t++) {
+		if (t < 16) {
+			message_ptr = (uint8_t*)&message_block[t];
+			w[t] = message_ptr[0] << 24 | message_ptr[1] << 16 |
+				   message_ptr[2] << 8 | message_ptr[3];
+		} else {
+			w[t] = SHA256_SSIG1(w[t - 2]) + w[t - 7] +
+				   SHA256_SSIG0(w[t - 15]) + w[t - 16];
+		}
+	}
+
+	/* initialize working variables */
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+	f = hash[5];
+	g = hash[6];
+	h = hash[7];
+
+	/* main hash computation */
+	for (t = 0; t < 64; t++) {
+		t1 = h + SHA256_BSIG1(e) + SHA_Ch(e, f, g) + K[t] + w[t];
+		t2 = SHA256_BSIG0(a) + SHA_Maj(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	/* calculate intermediate hash value H(i) */
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+	hash[5] += f;
+	hash[6] += g;
+	hash[7] += h;
+}
+
+/*****************************************************************************/
+/* Runtime dispatch between SHA-NI and the plain rounds above */
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define SHA256_X86
+
+/* Check CPU for SHA extensions and the SSE4.1 they are used with */
+static int sha256_has_shani(void) {
+	static int has_shani = -1;
+	unsigned int a, b, c, d;
+
+	if (has_shani == -1) {
+		has_shani = __get_cpuid_count(7, 0, &a, &b, &c, &d) &&
+					(b & bit_SHA) && __get_cpuid(1, &a, &b, &c, &d) &&
+					(c & bit_SSE4_1) && (c & bit_SSSE3);
+	}
+	return has_shani;
+}
+
+/* SHA-256 block with SHA-NI, state kept as ABEF and CDGH halves */
+__attribute__((target("sha,sse4.1,ssse3"))) static void
+sha256_process_shani(uint32_t message_block[16], uint32_t hash[8]) {
+	const __m128i mask =
+		_mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg, tmp;
+	__m128i w[16];
+	int i;
+
+	/* load state, reordering ABCD EFGH into ABEF CDGH */
+	tmp = _mm_loadu_si128((const __m128i*)&hash[0]);
+	state1 = _mm_loadu_si128((const __m128i*)&hash[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xB1);
+	state1 = _mm_shuffle_epi32(state1, 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	abef = state0;
+	cdgh = state1;
+
+	/* message schedule, four words per vector */
+	for (i = 0; i < 4; i++) {
+		w[i] = _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i*)message_block + i), mask);
+	}
+	for (i = 4; i < 16; i++) {
+		w[i] = _mm_sha256msg2_epu32(
+			_mm_add_epi32(_mm_sha256msg1_epu32(w[i - 4], w[i - 3]),
+						  _mm_alignr_epi8(w[i - 1], w[i - 2], 4)),
+			w[i - 1]);
+	}
+
+	/* two rounds per instruction */
+	for (i = 0; i < 16; i++) {
+		msg = _mm_add_epi32(w[i], _mm_loadu_si128((const __m128i*)&K[i * 4]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+	}
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+
+	/* store state back as ABCD EFGH */
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i*)&hash[0], state0);
+	_mm_storeu_si128((__m128i*)&hash[4], state1);
+}
+#endif
+
+/* Process one block with the fastest rounds the CPU has */
+static void sha256_compress(uint32_t message_block[16], uint32_t hash[8]) {
+#ifdef SHA256_X86
+	if (sha256_has_shani()) {
+		sha256_process_shani(message_block, hash);
+		return;
+	}
+#endif
+	sha256_process(message_block, hash);
+}
+
+/*****************************************************************************/
+/* Multi-buffer SHA-256, one message per vector lane */
+
+typedef uint32_t sha256_x4_t __attribute__((vector_size(16)));
+typedef uint32_t sha256_x8_t __attribute__((vector_size(32)));
+
+#define SHA256_LANE_ROTR(bits, word)                                          \
+	(((word) >> (bits)) | ((word) << (32 - (bits))))
+
+/* Define rounds over one block of every lane, the same as sha256_process */
+#define SHA256_DEFINE_LANES(name, lane_t, lanes, attr)                        \
+	attr static void name(const uint8_t* blocks[], lane_t hash[8]) {          \
+		lane_t w[64], a, b, c, d, e, f, g, h, t1, t2;                         \
+		int t, j;                                                             \
+		for (t = 0; t < 16; t++) {                                            \
+			for (j = 0; j < lanes; j++) {                                     \
+				const uint8_t* p = blocks[j] + t * 4;                         \
+				w[t][j] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |       \
+						  (uint32_t)p[2] << 8 | p[3];                         \
+			}                                                                 \
+		}                                                                     \
+		for (t = 16; t < 64; t++) {                                           \
+			w[t] = (SHA256_LANE_ROTR(17, w[t - 2]) ^                          \
+					SHA256_LANE_ROTR(19, w[t - 2]) ^ (w[t - 2] >> 10)) +      \
+				   w[t - 7] +                                                 \
+				   (SHA256_LANE_ROTR(7, w[t - 15]) ^                          \
+					SHA256_LANE_ROTR(18, w[t - 15]) ^ (w[t - 15] >> 3)) +     \
+				   w[t - 16];                                                 \
+		}                                                                     \
+		a = hash[0];                                                          \
+		b = hash[1];                                                          \
+		c = hash[2];                                                          \
+		d = hash[3];                                                          \
+		e = hash[4];                                                          \
+		f = hash[5];                                                          \
+		g = hash[6];                                                          \
+		h = hash[7];                                                          \
+		for (t = 0; t < 64; t++) {                                            \
+			t1 = h +                                                          \
+				 (SHA256_LANE_ROTR(6, e) ^ SHA256_LANE_ROTR(11, e) ^          \
+				  SHA256_LANE_ROTR(25, e)) +                                  \
+				 ((e & f) ^ (~e & g)) + K[t] + w[t];                          \
+			t2 = (SHA256_LANE_ROTR(2, a) ^ SHA256_LANE_ROTR(13, a) ^          \
+				  SHA256_LANE_ROTR(22, a)) +                                  \
+				 ((a & b) ^ (a & c) ^ (b & c));                               \
+			h = g;                                                            \
+			g = f;                                                            \
+			f = e;                                                            \
+			e = d + t1;                                                       \
+			d = c;                                                            \
+			c = b;                                                            \
+			b = a;                                                            \
+			a = t1 + t2;                                                      \
+		}                                                                     \
+		hash[0] += a;                                                         \
+		hash[1] += b;                                                         \
+		hash[2] += c;                                                         \
+		hash[3] += d;                                                         \
+		hash[4] += e;                                                         \
+		hash[5] += f;                                                         \
+		hash[6] += g;                                                         \
+		hash[7] += h;                                                         \
+	}
+
+SHA256_DEFINE_LANES(sha256_process_x4, sha256_x4_t, 4, )
+#ifdef SHA256_X86
+SHA256_DEFINE_LANES(sha256_process_x8, sha256_x8_t, 8,
+					__attribute__((target("avx2"))))
+#endif
+
+/* Pad message tail into one or two final blocks, return how many */
+static int sha256_pad_tail(uint8_t tail[128], const uint8_t* buf,
+						   uint64_t nbyte) {
+	int leftover_bytes, num_blocks, i;
+
+	leftover_bytes = nbyte % 64;
+	num_blocks = leftover_bytes > 64 - 8 - 1 ? 2 : 1;
+	memset(tail, 0, 128);
+	memcpy(tail, buf + nbyte - leftover_bytes, leftover_bytes);
+	tail[leftover_bytes] = 1 << 7;
+	for (i = 0; i < 8; i++) {
+		tail[num_blocks * 64 - 1 - i] = (nbyte * 8 >> (i * 8)) & 0xFF;
+	}
+	return num_blocks;
+}
+
+/* Hash group of messages, one per lane */
+#define SHA256_DEFINE_GROUP(name, lane_t, lanes, process, attr)               \
+	attr static void name(char (*hash_hexstrings)[65],                        \
+						  const uint8_t* const* bufs, uint64_t nbyte) {       \
+		uint8_t tail[lanes][128];                                             \
+		const uint8_t* blocks[lanes];                                         \
+		uint32_t out[8];                                                      \
+		lane_t hash[8];                                                       \
+		uint64_t i, full_blocks;                                              \
+		int j, k, tail_blocks = 0;                                            \
+		for (k = 0; k < 8; k++) {                                             \
+			for (j = 0; j < lanes; j++) {                                     \
+				hash[k][j] = SHA256_H0[k];                                    \
+			}                                                                 \
+		}                                                                     \
+		for (j = 0; j < lanes; j++) {                                         \
+			tail_blocks = sha256_pad_tail(tail[j], bufs[j], nbyte);           \
+		}                                                                     \
+		full_blocks = nbyte / 64;                                             \
+		for (i = 0; i < full_blocks + tail_blocks; i++) {                     \
+			for (j = 0; j < lanes; j++) {                                     \
+				blocks[j] = i < full_blocks                                   \
+								? bufs[j] + i * 64                            \
+								: tail[j] + (i - full_blocks) * 64;           \
+			}                                                                 \
+			process(blocks, hash);                                            \
+		}                                                                     \
+		for (j = 0; j < lanes; j++) {                                         \
+			for (k = 0; k < 8; k++) {                                         \
+				out[k] = hash[k][j];                                          \
+			}                                                                 \
+			uint32_array_to_hex_string(hash_hexstrings[j], out, 8);           \
+		}                                                                     \
+	}
+
+SHA256_DEFINE_GROUP(sha256_hash_x4, sha256_x4_t, 4, sha256_process_x4, )
+#ifdef SHA256_X86
+SHA256_DEFINE_GROUP(sha256_hash_x8, sha256_x8_t, 8, sha256_process_x8,
+					__attribute__((target("avx2"))))
+#endif
+
+/* Hash count messages of nbyte each, same result as sha256_hash on each */
+/* Single buffer SHA-NI is faster than lanes where the CPU has it */
+void sha256_hash_many(char (*hash_hexstrings)[65], const uint8_t* const* bufs,
+					  int count, const uint64_t nbyte) {
+	int i = 0;
+
+#ifdef SHA256_X86
+	if (!sha256_has_shani() && __builtin_cpu_supports("avx2")) {
+		for (; i + 8 <= count; i += 8) {
+			sha256_hash_x8(hash_hexstrings + i, bufs + i, nbyte);
+		}
+	}
+	if (!sha256_has_shani()) {
+		for (; i + 4 <= count; i += 4) {
+			sha256_hash_x4(hash_hexstrings + i, bufs + i, nbyte);
+		}
+	}
+#else
+	for (; i + 4 <= count; i += 4) {
+		sha256_hash_x4(hash_hexstrings + i, bufs + i, nbyte);
+	}
+#endif
+	for (; i < count; i++) {
+		sha256_hash(hash_hexstrings[i], bufs[i], nbyte);
+	}
+}
+
+/* SHA-256 processing for final block */
+/* Padding - "1" followed by m "0"s followed by 64-bit integer */
+/* https://www.rfc-editor.org/rfc/rfc6234#section-4.1 */
+static void sha256_process_final(uint64_t nbyte, short leftover_bytes,
+								 uint32_t last_block[16], uint32_t hash[8]) {
+	/* Append "1" bit */
+	((uint8_t*)last_block)[leftover_bytes] = 1 << 7;
+
+	/* Length will be in next block since it doesn't fit */
+	if (leftover_bytes > 64 - 8 - 1) {
+		sha256_compress(last_block, hash);
+		memset(last_block, 0, 64);
+	}
+
+	/* Set length, process last block */
+	((uint8_t*)last_block)[56] = (nbyte * 8 >> (64 - 8)) & 0xFF;
+	((uint8_t*)last_block)[57] = (nbyte * 8 >> (64 - 16)) & 0xFF;
+	((uint8_t*)last_block)[58] = (nbyte * 8 >> (64 - 24)) & 0xFF;
+	((uint8_t*)last_block)[59] = (nbyte * 8 >> (64 - 32)) & 0xFF;
+	((uint8_t*)last_block)[60] = (nbyte * 8 >> (64 - 40)) & 0xFF;
+	((uint8_t*)last_block)[61] = (nbyte * 8 >> (64 - 48)) & 0xFF;
+	((uint8_t*)last_block)[62] = (nbyte * 8 >> (64 - 56)) & 0xFF;
+	((uint8_t*)last_block)[63] = (nbyte * 8 >> (64 - 64)) & 0xFF;
+
+	sha256_compress(last_block, hash);
+}
+
+#ifdef DEBUG
+/* Prints a uint32 array */
+static void print_uint32_array(uint32_t* arr, unsigned long length) {
+	unsigned long i;
+	for (i = 0; i < length; i++) {
+		fprintf(stderr, "%08x", arr[i]);
+	}
+	fprintf(stderr, "\n");
+}
+#endif
+
+/* Returns a uint32 array in hex notation */
+static void uint32_array_to_hex_string(char* out, uint32_t* in,
+									   unsigned long length) {
+	static const char digits[] = "0123456789abcdef";
+	int i, k;
+	for (i = 0; i < length; i++) {
+		for (k = 0; k < 8; k++) {
+			out[i * 8 + k] = digits[(in[i] >> (28 - k * 4)) & 0xF];
+		}
+	}
+	out[64] = 0;
+}
@@ -0,0 +1,19 @@
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+void sha256_hash(char hash_hexstring[65], const uint8_t* buf,
+				 const uint64_t nbyte);
+
+void sha256_hash_many(char (*hash_hexstrings)[65], const uint8_t* const* bufs,
+					  int count, const uint64_t nbyte);
+
+#endif
\ No newline at end of file
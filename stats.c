@@ -0,0 +1,262 @@
+#include "stats.h"
+
+static const char *metric_names[STAT_METRICS] = {
+    "turnaround", "waiting", "response", "slowdown"
+};
+
+// Class 0 takes every process, the rest split by memory size
+static const char *class_names[STAT_CLASSES] = {
+    "all", "small", "medium", "large", "huge"
+};
+static const int class_limits[STAT_CLASSES] = {0, 64, 256, 1024, INT_MAX};
+
+static const double quantiles[STAT_QUANTILES] = {0.5, 0.9, 0.99, 0.999};
+static const char *quantile_names[STAT_QUANTILES] = {
+    "p50", "p90", "p99", "p999"
+};
+
+// P-square estimate of one quantile in five markers, Jain and Chlamtac
+// markers start from the exact samples once there are too many to keep
+typedef struct sketch {
+    double height[5];
+    double pos[5];
+    double want[5];
+    double step[5];
+} sketch_t;
+
+typedef struct summary {
+    long long count;
+    double sum;
+    double max;
+    double exact[STAT_EXACT];
+    sketch_t sketch[STAT_QUANTILES];
+} summary_t;
+
+struct stats
+{
+    // totals behind the usual summary lines
+    long long turnaround;
+    double max_overhead;
+    double total_overhead;
+
+    summary_t summary[STAT_METRICS][STAT_CLASSES];
+};
+
+
+// Create empty statistics
+stats_t *create_stats(arena_t *arena) {
+    return arena_calloc(arena, 1, sizeof(stats_t));
+}
+
+
+// Compare samples for sorting
+static int compare_sample(const void *a, const void *b) {
+    double x = *(double *)a;
+    double y = *(double *)b;
+    return (x > y) - (x < y);
+}
+
+
+// Place markers over n sorted samples, at the minimum, p / 2, p, 
+// (1 + p) / 2 and the maximum, each on a sample of its own
+static void start_sketch(sketch_t *sketch, double p, double *sorted, 
+                         int n) {
+    double fraction[5] = {0, p / 2, p, (1 + p) / 2, 1};
+    for (int k = 0; k < 5; k++) {
+        sketch->want[k] = (n - 1) * fraction[k];
+        sketch->step[k] = fraction[k];
+        sketch->pos[k] = round(sketch->want[k]);
+        if (k > 0 && sketch->pos[k] <= sketch->pos[k - 1]) {
+            sketch->pos[k] = sketch->pos[k - 1] + 1;
+        }
+    }
+    sketch->pos[4] = n - 1;
+    for (int k = 3; k >= 0; k--) {
+        if (sketch->pos[k] >= sketch->pos[k + 1]) {
+            sketch->pos[k] = sketch->pos[k + 1] - 1;
+        }
+    }
+    for (int k = 0; k < 5; k++) {
+        sketch->height[k] = sorted[(int)sketch->pos[k]];
+    }
+}
+
+
+// Move marker k by one towards where it should be, parabolic if the
+// result stays between its neighbours, linear otherwise
+static void move_marker(sketch_t *sketch, int k, int d) {
+    double *q = sketch->height;
+    double *n = sketch->pos;
+    double parabolic = q[k] + d / (n[k + 1] - n[k - 1]) * 
+        ((n[k] - n[k - 1] + d) * (q[k + 1] - q[k]) / (n[k + 1] - n[k]) + 
+         (n[k + 1] - n[k] - d) * (q[k] - q[k - 1]) / (n[k] - n[k - 1]));
+    if (q[k - 1] < parabolic && parabolic < q[k + 1]) {
+        q[k] = parabolic;
+    } else {
+        q[k] += d * (q[k + d] - q[k]) / (n[k + d] - n[k]);
+    }
+    n[k] += d;
+}
+
+
+// Add sample to a started sketch
+static void add_to_sketch(sketch_t *sketch, double x) {
+
+    double *q = sketch->height;
+
+    // find cell of sample, stretching the ends if needed
+    int cell;
+    if (x < q[0]) {
+        q[0] = x;
+        cell = 0;
+    } else if (x >= q[4]) {
+        q[4] = x;
+        cell = 3;
+    } else {
+        cell = 0;
+        while (x >= q[cell + 1]) cell++;
+    }
+    for (int k = cell + 1; k < 5; k++) {
+        sketch->pos[k]++;
+    }
+    for (int k = 0; k < 5; k++) {
+        sketch->want[k] += sketch->step[k];
+    }
+
+    // adjust middle markers drifting a whole position off
+    for (int k = 1; k < 4; k++) {
+        double drift = sketch->want[k] - sketch->pos[k];
+        if ((drift >= 1 && sketch->pos[k + 1] - sketch->pos[k] > 1) || 
+            (drift <= -1 && sketch->pos[k - 1] - sketch->pos[k] < -1)) {
+            move_marker(sketch, k, drift > 0 ? 1 : -1);
+        }
+    }
+}
+
+
+// Add sample to summary of one metric and class, keeping samples
+// exactly until there are STAT_EXACT of them
+static void add_to_summary(summary_t *summary, double x) {
+    if (summary->count < STAT_EXACT) {
+        summary->exact[summary->count] = x;
+    } else {
+        if (summary->count == STAT_EXACT) {
+            qsort(summary->exact, STAT_EXACT, sizeof(double), 
+                  compare_sample);
+            for (int k = 0; k < STAT_QUANTILES; k++) {
+                start_sketch(&summary->sketch[k], quantiles[k], 
+                             summary->exact, STAT_EXACT);
+            }
+        }
+        for (int k = 0; k < STAT_QUANTILES; k++) {
+            add_to_sketch(&summary->sketch[k], x);
+        }
+    }
+    if (summary->count == 0 || x > summary->max) summary->max = x;
+    summary->sum += x;
+    summary->count++;
+}
+
+
+// Get every quantile of summary, nearest rank while samples are kept
+// and from the sketches after, never below the quantile before it
+// nor above the maximum
+static void read_quantiles(summary_t *summary, double *values) {
+    double sorted[STAT_EXACT];
+    int kept = summary->count <= STAT_EXACT ? summary->count : 0;
+    memcpy(sorted, summary->exact, kept * sizeof(double));
+    qsort(sorted, kept, sizeof(double), compare_sample);
+    for (int k = 0; k < STAT_QUANTILES; k++) {
+        if (kept > 0) {
+            int rank = (int)ceil(quantiles[k] * kept) - 1;
+            if (rank < 0) rank = 0;
+            values[k] = sorted[rank];
+        } else {
+            values[k] = summary->sketch[k].height[2];
+        }
+        if (k > 0 && values[k] < values[k - 1]) values[k] = values[k - 1];
+        if (values[k] > summary->max) values[k] = summary->max;
+    }
+}
+
+
+// Add sample of metric to overall and memory class summaries
+static void add_sample(stats_t *stats, int metric, int size, double x) {
+    int class = 1;
+    while (size > class_limits[class]) class++;
+    add_to_summary(&stats->summary[metric][0], x);
+    add_to_summary(&stats->summary[metric][class], x);
+}
+
+
+// Record process first getting the cpu
+void record_start(stats_t *stats, long long arrival, int size, 
+                  long long time) {
+    add_sample(stats, STAT_RESPONSE, size, time - arrival);
+}
+
+
+// Add finished process to turnaround and overhead statistics
+void record_finish(stats_t *stats, long long arrival, long long service, 
+                   int size, long long time) {
+    double overhead = (double)(time - arrival) / service;
+    stats->turnaround = stats->turnaround + (time - arrival);
+    if (overhead > stats->max_overhead) {
+        stats->max_overhead = overhead;
+    }
+    stats->total_overhead = stats->total_overhead + overhead;
+
+    add_sample(stats, STAT_TURNAROUND, size, time - arrival);
+    add_sample(stats, STAT_WAITING, size, time - arrival - service);
+    add_sample(stats, STAT_SLOWDOWN, size, overhead);
+}
+
+
+// Get total turnaround of finished processes
+long long get_stats_turnaround(stats_t *stats) {
+    return stats->turnaround;
+}
+
+
+// Get highest overhead of finished processes
+double get_stats_max_overhead(stats_t *stats) {
+    return stats->max_overhead;
+}
+
+
+// Get total overhead of finished processes
+double get_stats_total_overhead(stats_t *stats) {
+    return stats->total_overhead;
+}
+
+
+// Print mean, quantiles and max of every metric and non empty class
+void print_stats(FILE *out, stats_t *stats) {
+    for (int m = 0; m < STAT_METRICS; m++) {
+        for (int c = 0; c < STAT_CLASSES; c++) {
+            summary_t *summary = &stats->summary[m][c];
+            if (summary->count == 0) continue;
+            fprintf(out, "Stats %s %s n %lld mean %.2lf", metric_names[m], 
+                    class_names[c], summary->count, 
+                    summary->sum / summary->count);
+            double values[STAT_QUANTILES];
+            read_quantiles(summary, values);
+            for (int k = 0; k < STAT_QUANTILES; k++) {
+                fprintf(out, " %s %.2lf", quantile_names[k], values[k]);
+            }
+            fprintf(out, " max %.2lf\n", summary->max);
+        }
+    }
+}
+
+
+// Write statistics, all of them fixed size
+void save_stats(stats_t *stats, FILE *file) {
+    fwrite(stats, sizeof(stats_t), 1, file);
+}
+
+
+// Read statistics written by save_stats
+void load_stats(stats_t *stats, FILE *file) {
+    fread(stats, sizeof(stats_t), 1, file);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#include "arena.h"
+
+// Per process metrics, each summarised overall and by memory class
+#define STAT_TURNAROUND 0
+#define STAT_WAITING 1
+#define STAT_RESPONSE 2
+#define STAT_SLOWDOWN 3
+#define STAT_METRICS 4
+
+#define STAT_CLASSES 5
+#define STAT_QUANTILES 4
+
+// Samples kept exactly per metric and class before sketching
+#define STAT_EXACT 512
+
+typedef struct stats stats_t;
+
+stats_t *create_stats(arena_t *arena);
+
+void record_start(stats_t *stats, long long arrival, int size, 
+                  long long time);
+
+void record_finish(stats_t *stats, long long arrival, long long service, 
+                   int size, long long time);
+
+long long get_stats_turnaround(stats_t *stats);
+
+double get_stats_max_overhead(stats_t *stats);
+
+double get_stats_total_overhead(stats_t *stats);
+
+void print_stats(FILE *out, stats_t *stats);
+
+void save_stats(stats_t *stats, FILE *file);
+
+void load_stats(stats_t *stats, FILE *file);
+
+#endif
\ No newline at end of file
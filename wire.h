@@ -0,0 +1,33 @@
+#ifndef _WIRE_H_
+#define _WIRE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Times sent to process.c, big endian
+// times below the escape go in 4 bytes as they always have, the rest as
+// the escape and 8 more bytes, so handshakes of runs which fit are
+// unchanged
+#define WIRE_ESCAPE 0xFFFFFFFFu
+#define WIRE_MAX_TIME 12
+
+// Write time into buf as it goes on the wire, return bytes written
+static inline size_t put_time(uint8_t *buf, uint64_t time) {
+    size_t len = 0;
+    if (time >= WIRE_ESCAPE) {
+        for (int k = 3; k >= 0; k--) buf[len++] = WIRE_ESCAPE >> (8 * k);
+        for (int k = 7; k >= 0; k--) buf[len++] = time >> (8 * k);
+        return len;
+    }
+    for (int k = 3; k >= 0; k--) buf[len++] = time >> (8 * k);
+    return len;
+}
+
+// Read big endian value of len bytes from buf
+static inline uint64_t get_wire(const uint8_t *buf, size_t len) {
+    uint64_t value = 0;
+    for (size_t k = 0; k < len; k++) value = value << 8 | buf[k];
+    return value;
+}
+
+#endif
\ No newline at end of file